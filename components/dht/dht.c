@@ -41,10 +41,18 @@
 #include "dht.h"
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <string.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
+#include <dlog.h>
+
+#if HELPER_TARGET_IS_ESP32 && CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#define DHT_PM_LOCK 1
+#endif
 
 // DHT timer precision in microseconds
 #define DHT_TIMER_INTERVAL 2
@@ -79,8 +87,6 @@
  *
  */
 
-static const char *TAG = "dht";
-
 #if HELPER_TARGET_IS_ESP32
 static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 #define PORT_ENTER_CRITICAL() portENTER_CRITICAL(&mux)
@@ -93,11 +99,20 @@ static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
-#define CHECK_LOGE(x, msg, ...) do { \
+#ifdef DHT_PM_LOCK
+// Bit timing relies on ets_delay_us() busy-waits, which assume a fixed CPU
+// clock. Keep the CPU at its maximum frequency and out of light sleep for the
+// duration of a read.
+static esp_pm_lock_handle_t pm_lock;
+#endif
+
+// Errors are logged through the deferred log (dlog), so the read path never
+// waits on the console UART. Messages live in dlog_formats.h.
+#define CHECK_LOGE(x, id) do { \
         esp_err_t __; \
         if ((__ = x) != ESP_OK) { \
             PORT_EXIT_CRITICAL(); \
-            ESP_LOGE(TAG, msg, ## __VA_ARGS__); \
+            DLOG(id); \
             return __; \
         } \
     } while (0)
@@ -149,22 +164,17 @@ static inline esp_err_t dht_fetch_data(dht_sensor_type_t sensor_type, gpio_num_t
     gpio_set_level(pin, 1);
 
     // Step through Phase 'B', 40us
-    CHECK_LOGE(dht_await_pin_state(pin, 40, 0, NULL),
-            "Initialization error, problem in phase 'B'");
+    CHECK_LOGE(dht_await_pin_state(pin, 40, 0, NULL), DLOG_DHT_PHASE_B);
     // Step through Phase 'C', 88us
-    CHECK_LOGE(dht_await_pin_state(pin, 88, 1, NULL),
-            "Initialization error, problem in phase 'C'");
+    CHECK_LOGE(dht_await_pin_state(pin, 88, 1, NULL), DLOG_DHT_PHASE_C);
     // Step through Phase 'D', 88us
-    CHECK_LOGE(dht_await_pin_state(pin, 88, 0, NULL),
-            "Initialization error, problem in phase 'D'");
+    CHECK_LOGE(dht_await_pin_state(pin, 88, 0, NULL), DLOG_DHT_PHASE_D);
 
     // Read in each of the 40 bits of data...
     for (int i = 0; i < DHT_DATA_BITS; i++)
     {
-        CHECK_LOGE(dht_await_pin_state(pin, 65, 1, &low_duration),
-                "LOW bit timeout");
-        CHECK_LOGE(dht_await_pin_state(pin, 75, 0, &high_duration),
-                "HIGH bit timeout");
+        CHECK_LOGE(dht_await_pin_state(pin, 65, 1, &low_duration), DLOG_DHT_LOW_TIMEOUT);
+        CHECK_LOGE(dht_await_pin_state(pin, 75, 0, &high_duration), DLOG_DHT_HIGH_TIMEOUT);
 
         uint8_t b = i / 8;
         uint8_t m = i % 8;
@@ -207,6 +217,12 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
 
     uint8_t data[DHT_DATA_BYTES] = { 0 };
 
+#ifdef DHT_PM_LOCK
+    if (!pm_lock)
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "dht", &pm_lock);
+    esp_pm_lock_acquire(pm_lock);
+#endif
+
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
     gpio_set_level(pin, 1);
 
@@ -220,12 +236,16 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
     gpio_set_level(pin, 1);
 
+#ifdef DHT_PM_LOCK
+    esp_pm_lock_release(pm_lock);
+#endif
+
     if (result != ESP_OK)
         return result;
 
     if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
     {
-        ESP_LOGE(TAG, "Checksum failed, invalid data received from sensor");
+        DLOG(DLOG_DHT_CRC);
         return ESP_ERR_INVALID_CRC;
     }
 
@@ -234,7 +254,7 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
     if (temperature)
         *temperature = dht_convert_data(sensor_type, data[2], data[3]);
 
-    ESP_LOGD(TAG, "Sensor data: humidity=%d, temp=%d", *humidity, *temperature);
+    DLOG(DLOG_DHT_DATA, humidity ? *humidity : 0, temperature ? *temperature : 0);
 
     return ESP_OK;
 }
@@ -257,3 +277,147 @@ esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
 
     return ESP_OK;
 }
+
+// Edges seen after the line is released: end of phases B, C and D, then the
+// end of the low and of the high half of each bit
+#define DHT_MULTI_EDGES (3 + 2 * DHT_DATA_BITS)
+// Longest reply: phases B-D plus 40 bits at their slowest
+#define DHT_MULTI_TIMEOUT_US (40 + 88 + 88 + DHT_DATA_BITS * (65 + 75))
+
+typedef struct
+{
+    int level;
+    uint32_t edge_us;   // time of the previous edge
+    uint32_t low_us;    // low half of the bit being received
+    uint8_t edges;
+    uint8_t data[DHT_DATA_BYTES];
+} dht_multi_state_t;
+
+static inline void dht_multi_edge(dht_multi_state_t *st, uint32_t now)
+{
+    uint32_t duration = now - st->edge_us;
+    st->edge_us = now;
+    if (++st->edges < 4)
+        return; // phases B, C and D
+
+    int i = (st->edges - 4) / 2;
+    if ((st->edges - 4) % 2 == 0)
+    {
+        st->low_us = duration; // rising edge: end of the low half
+        return;
+    }
+    // falling edge: the high half is longer than the low one for a '1'
+    st->data[i / 8] |= (duration > st->low_us) << (7 - i % 8);
+}
+
+// Maps where the reply stopped to the same errors as dht_fetch_data()
+static esp_err_t dht_multi_check(const dht_multi_state_t *st)
+{
+    static const dlog_id_t phase_ids[] = { DLOG_DHT_PHASE_B, DLOG_DHT_PHASE_C, DLOG_DHT_PHASE_D };
+
+    if (st->edges == DHT_MULTI_EDGES)
+        return ESP_OK;
+    if (st->edges < 3)
+        DLOG(phase_ids[st->edges]);
+    else if ((st->edges - 3) % 2 == 0)
+        DLOG(DLOG_DHT_LOW_TIMEOUT);
+    else
+        DLOG(DLOG_DHT_HIGH_TIMEOUT);
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t dht_read_multi(dht_multi_t *sensors, size_t count)
+{
+    CHECK_ARG(sensors && count && count <= DHT_MULTI_MAX);
+
+    dht_multi_state_t st[DHT_MULTI_MAX];
+    memset(st, 0, sizeof(st));
+
+    // The longest start pulse required among the sensors
+    uint32_t start_ms = 1;
+    for (size_t i = 0; i < count; i++)
+        if (sensors[i].sensor_type != DHT_TYPE_SI7021)
+            start_ms = 20;
+
+#ifdef DHT_PM_LOCK
+    if (!pm_lock)
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "dht", &pm_lock);
+    esp_pm_lock_acquire(pm_lock);
+#endif
+
+    // Phase 'A' for all sensors. Only its minimum length matters, so the task
+    // blocks instead of busy-waiting; one extra tick covers a partial tick.
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_set_direction(sensors[i].pin, GPIO_MODE_OUTPUT_OD);
+        gpio_set_level(sensors[i].pin, 0);
+    }
+    vTaskDelay(pdMS_TO_TICKS(start_ms) + 1);
+
+    PORT_ENTER_CRITICAL();
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_set_level(sensors[i].pin, 1);
+        gpio_set_direction(sensors[i].pin, GPIO_MODE_INPUT);
+        st[i].level = 1;
+    }
+    // Let the lines float up before looking for the sensors pulling them low
+    ets_delay_us(DHT_TIMER_INTERVAL);
+    uint32_t start = (uint32_t)esp_timer_get_time();
+    for (size_t i = 0; i < count; i++)
+        st[i].edge_us = start;
+
+    // Single polling loop for every line; each sensor decodes its own edges
+    size_t pending = count;
+    uint32_t now = start;
+    while (pending && now - start < DHT_MULTI_TIMEOUT_US)
+    {
+        now = (uint32_t)esp_timer_get_time();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (st[i].edges == DHT_MULTI_EDGES)
+                continue;
+            int level = gpio_get_level(sensors[i].pin);
+            if (level == st[i].level)
+                continue;
+            st[i].level = level;
+            dht_multi_edge(&st[i], now);
+            if (st[i].edges == DHT_MULTI_EDGES)
+                pending--;
+        }
+    }
+    PORT_EXIT_CRITICAL();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_set_direction(sensors[i].pin, GPIO_MODE_OUTPUT_OD);
+        gpio_set_level(sensors[i].pin, 1);
+    }
+
+#ifdef DHT_PM_LOCK
+    esp_pm_lock_release(pm_lock);
+#endif
+
+    esp_err_t result = ESP_OK;
+    for (size_t i = 0; i < count; i++)
+    {
+        dht_multi_t *s = &sensors[i];
+        const uint8_t *data = st[i].data;
+        s->result = dht_multi_check(&st[i]);
+        if (s->result == ESP_OK && data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
+        {
+            DLOG(DLOG_DHT_CRC);
+            s->result = ESP_ERR_INVALID_CRC;
+        }
+        if (s->result == ESP_OK)
+        {
+            s->humidity = dht_convert_data(s->sensor_type, data[0], data[1]);
+            s->temperature = dht_convert_data(s->sensor_type, data[2], data[3]);
+            DLOG(DLOG_DHT_DATA, s->humidity, s->temperature);
+        }
+        else if (result == ESP_OK)
+            result = s->result;
+    }
+
+    return result;
+}
@@ -46,6 +46,7 @@
 #ifndef __DHT_H__
 #define __DHT_H__
 
+#include <stddef.h>
 #include <driver/gpio.h>
 #include <esp_err.h>
 
@@ -92,6 +93,37 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
 esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
         float *humidity, float *temperature);
 
+/**
+ * Maximum number of sensors in a single dht_read_multi() call
+ */
+#define DHT_MULTI_MAX 16
+
+/**
+ * Sensor taking part in a dht_read_multi() call
+ */
+typedef struct
+{
+    dht_sensor_type_t sensor_type;  //!< Sensor type
+    gpio_num_t pin;                 //!< GPIO pin connected to sensor OUT
+    int16_t humidity;               //!< [out] Humidity, percents * 10
+    int16_t temperature;            //!< [out] Temperature, degrees Celsius * 10
+    esp_err_t result;               //!< [out] `ESP_OK` if this sensor was read
+} dht_multi_t;
+
+/**
+ * @brief Read several sensors on different pins at once
+ *
+ * All sensors are triggered together and their replies are decoded by a
+ * single polling loop, so the read takes about as long as reading one sensor.
+ * The start pulse is timed with the task blocked, so only the reply (~5 ms)
+ * runs inside the critical section.
+ *
+ * @param[in,out] sensors Sensors to read; results are stored in each entry
+ * @param count Number of sensors, up to DHT_MULTI_MAX
+ * @return `ESP_OK` if every sensor was read, otherwise the first error
+ */
+esp_err_t dht_read_multi(dht_multi_t *sensors, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,158 @@
+#include "dlog.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#if CONFIG_DLOG_OUTPUT_BINARY
+#include "driver/uart_vfs.h"
+#endif
+
+#define RING_MASK (CONFIG_DLOG_RING_LEN - 1)
+
+_Static_assert((CONFIG_DLOG_RING_LEN & RING_MASK) == 0, "CONFIG_DLOG_RING_LEN deve ser potência de 2");
+_Static_assert(sizeof(dlog_record_t) == 32, "dlog_record_t deve ter 32 bytes");
+
+// Anel limitado de múltiplos produtores e um consumidor (algoritmo de
+// D. Vyukov): cada posição tem um número de sequência que indica se está
+// livre para o produtor da volta atual ou pronta para o consumidor. O valor
+// guardado é a sequência menos o índice da posição, para que o anel zerado
+// pela inicialização estática já esteja pronto antes de dlog_start().
+typedef struct {
+    atomic_uint seq;
+    dlog_record_t rec;
+} cell_t;
+
+static cell_t s_ring[CONFIG_DLOG_RING_LEN];
+static atomic_uint s_enqueue_pos;
+static unsigned s_dequeue_pos;          // Só a tarefa de log usa
+static atomic_uint s_dropped;           // Registros perdidos com o anel cheio
+
+static StaticTask_t s_task_buf;
+static StackType_t s_task_stack[3072];
+static TaskHandle_t s_task;             // Tarefa de log, acordada por notificação
+
+// Níveis de cada formato, para filtrar na origem o que nunca seria exibido
+static const uint8_t s_levels[] = {
+#define DLOG_FORMAT(id, level, tag, fmt) ESP_LOG_##level,
+#define ESP_LOG_E ESP_LOG_ERROR
+#define ESP_LOG_W ESP_LOG_WARN
+#define ESP_LOG_I ESP_LOG_INFO
+#define ESP_LOG_D ESP_LOG_DEBUG
+#define ESP_LOG_V ESP_LOG_VERBOSE
+#include "dlog_formats.h"
+#undef DLOG_FORMAT
+};
+
+// Acorda a tarefa de log; ela tem prioridade baixa e só roda quando quem registrou ceder a CPU
+static void wake_task(void) {
+    TaskHandle_t task = s_task;
+    if (!task) return; // Antes de dlog_start() os registros só esperam no anel
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    } else {
+        xTaskNotifyGive(task);
+    }
+}
+
+void dlog_write(unsigned id, const uint32_t *args, unsigned nargs) {
+    if (id >= DLOG_COUNT || s_levels[id] > CONFIG_LOG_DEFAULT_LEVEL) return;
+
+    unsigned pos = atomic_load_explicit(&s_enqueue_pos, memory_order_relaxed);
+    cell_t *cell;
+    while (1) {
+        cell = &s_ring[pos & RING_MASK];
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire) + (pos & RING_MASK);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            // Posição livre: tenta reservá-la
+            if (atomic_compare_exchange_weak_explicit(&s_enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed); // Anel cheio
+            wake_task();
+            return;
+        } else {
+            pos = atomic_load_explicit(&s_enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    if (nargs > DLOG_MAX_ARGS) nargs = DLOG_MAX_ARGS;
+    cell->rec.sync = DLOG_SYNC;
+    cell->rec.id = id;
+    cell->rec.nargs = nargs;
+    cell->rec.timestamp_ms = esp_log_timestamp();
+    memcpy(cell->rec.args, args, nargs * sizeof(uint32_t));
+    atomic_store_explicit(&cell->seq, pos + 1 - (pos & RING_MASK), memory_order_release);
+    wake_task();
+}
+
+// Retira o próximo registro pronto do anel
+static bool dlog_read(dlog_record_t *out) {
+    unsigned idx = s_dequeue_pos & RING_MASK;
+    cell_t *cell = &s_ring[idx];
+    unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire) + idx;
+    if ((int)(seq - (s_dequeue_pos + 1)) < 0) return false;
+    *out = cell->rec;
+    atomic_store_explicit(&cell->seq, s_dequeue_pos + CONFIG_DLOG_RING_LEN - idx, memory_order_release);
+    s_dequeue_pos++;
+    return true;
+}
+
+static void emit(const dlog_record_t *rec) {
+#if CONFIG_DLOG_OUTPUT_BINARY
+    fwrite(rec, sizeof(*rec), 1, stdout);
+#else
+    char msg[160];
+    dlog_format(rec, msg, sizeof(msg));
+    esp_log_write(s_levels[rec->id], dlog_tag(rec->id), "%c (%lu) %s: %s\n", dlog_level(rec->id),
+                  (unsigned long)rec->timestamp_ms, dlog_tag(rec->id), msg);
+#endif
+}
+
+// Tarefa de baixa prioridade que formata e escreve os registros pendentes.
+// Dorme sem prazo até o primeiro registro, para não impedir o light sleep.
+static void dlog_task(void *pvParameters) {
+    dlog_record_t rec;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (dlog_read(&rec)) {
+            emit(&rec);
+        }
+        unsigned dropped = atomic_exchange(&s_dropped, 0);
+        if (dropped) {
+            rec = (dlog_record_t){
+                .sync = DLOG_SYNC,
+                .id = DLOG_DROPPED,
+                .nargs = 1,
+                .timestamp_ms = esp_log_timestamp(),
+                .args = {dropped},
+            };
+            emit(&rec);
+        }
+#if CONFIG_DLOG_OUTPUT_BINARY
+        fflush(stdout);
+#endif
+        // Agrupa os registros seguintes numa só escrita
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DLOG_DRAIN_PERIOD_MS));
+    }
+}
+
+void dlog_start(void) {
+#if CONFIG_DLOG_OUTPUT_BINARY
+    // Sem isso a console troca cada byte 0x0A dos registros por 0x0D 0x0A
+    // (CONFIG_NEWLIB_STDOUT_LINE_ENDING_CRLF) e corrompe o dump
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
+    s_task = xTaskCreateStatic(dlog_task, "dlog_task", sizeof(s_task_stack), NULL, CONFIG_DLOG_TASK_PRIORITY,
+                               s_task_stack, &s_task_buf);
+    xTaskNotifyGive(s_task); // Escreve o que foi registrado antes da partida
+}
@@ -0,0 +1,98 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Log diferido: os pontos de log gravam apenas o ID do formato e os
+// argumentos brutos num anel sem trava; uma tarefa de baixa prioridade
+// formata e escreve na console depois. Quem registra nunca espera pela UART.
+//
+// Uso:  DLOG(DLOG_SENSOR_LEITURA, linha, valor, bruto);
+// Os formatos ficam em dlog_formats.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_MAX_ARGS 6
+#define DLOG_SYNC     0xA55A   // Marca o início de cada registro nos dumps binários
+
+typedef enum {
+#define DLOG_FORMAT(id, level, tag, fmt) id,
+#include "dlog_formats.h"
+#undef DLOG_FORMAT
+    DLOG_COUNT
+} dlog_id_t;
+
+// Registro bruto (32 bytes), gravado no anel e nos dumps binários
+typedef struct {
+    uint16_t sync;                  // DLOG_SYNC
+    uint8_t id;                     // dlog_id_t
+    uint8_t nargs;
+    uint32_t timestamp_ms;          // ms desde o boot
+    uint32_t args[DLOG_MAX_ARGS];   // Inteiros ou bits de float, conforme o formato
+} dlog_record_t;
+
+// Seção de formatação (C puro, usada também por tools/dlog_decode.c)
+
+// Nível ('E', 'W', 'I', 'D', 'V'), tag e formato de um ID
+char dlog_level(unsigned id);
+const char *dlog_tag(unsigned id);
+const char *dlog_fmt(unsigned id);
+
+// Número de argumentos esperado pelo formato
+unsigned dlog_count_args(const char *fmt);
+
+// Formata a mensagem do registro (sem prefixo de nível/tag); retorna o tamanho
+int dlog_format(const dlog_record_t *rec, char *buf, size_t len);
+
+// Seção de registro (firmware)
+
+// Inicia a tarefa que esvazia o anel
+void dlog_start(void);
+
+// Grava um registro no anel sem bloquear e notifica a tarefa de log; descarta
+// se o anel estiver cheio. Pode ser chamada de interrupções, mas não dentro
+// de uma seção crítica (portENTER_CRITICAL).
+void dlog_write(unsigned id, const uint32_t *args, unsigned nargs);
+
+// Conversão dos argumentos para palavras de 32 bits conforme o tipo
+static inline uint32_t dlog_float_word(double v) {
+    float f = (float)v;
+    uint32_t w;
+    memcpy(&w, &f, sizeof(w));
+    return w;
+}
+
+static inline uint32_t dlog_int_word(int32_t v) {
+    return (uint32_t)v;
+}
+
+#define DLOG_WORD(x) _Generic((x), float: dlog_float_word, double: dlog_float_word, default: dlog_int_word)(x)
+
+#define DLOG_MAP0()
+#define DLOG_MAP1(a) DLOG_WORD(a)
+#define DLOG_MAP2(a, b) DLOG_WORD(a), DLOG_WORD(b)
+#define DLOG_MAP3(a, b, c) DLOG_MAP2(a, b), DLOG_WORD(c)
+#define DLOG_MAP4(a, b, c, d) DLOG_MAP3(a, b, c), DLOG_WORD(d)
+#define DLOG_MAP5(a, b, c, d, e) DLOG_MAP4(a, b, c, d), DLOG_WORD(e)
+#define DLOG_MAP6(a, b, c, d, e, f) DLOG_MAP5(a, b, c, d, e), DLOG_WORD(f)
+
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b) a##b
+
+// Registra uma mensagem do formato `id` com até DLOG_MAX_ARGS argumentos
+#define DLOG(id, ...) do { \
+        const uint32_t dlog_args_[] = {0, DLOG_CAT(DLOG_MAP, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)}; \
+        dlog_write((id), dlog_args_ + 1, DLOG_NARGS(__VA_ARGS__)); \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
@@ -0,0 +1,104 @@
+#include "dlog.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+static const char s_levels[] = {
+#define DLOG_FORMAT(id, level, tag, fmt) #level[0],
+#include "dlog_formats.h"
+#undef DLOG_FORMAT
+};
+
+static const char *const s_tags[] = {
+#define DLOG_FORMAT(id, level, tag, fmt) tag,
+#include "dlog_formats.h"
+#undef DLOG_FORMAT
+};
+
+static const char *const s_fmts[] = {
+#define DLOG_FORMAT(id, level, tag, fmt) fmt,
+#include "dlog_formats.h"
+#undef DLOG_FORMAT
+};
+
+char dlog_level(unsigned id) {
+    return id < DLOG_COUNT ? s_levels[id] : '?';
+}
+
+const char *dlog_tag(unsigned id) {
+    return id < DLOG_COUNT ? s_tags[id] : "?";
+}
+
+const char *dlog_fmt(unsigned id) {
+    return id < DLOG_COUNT ? s_fmts[id] : NULL;
+}
+
+// Avança sobre uma especificação de conversão a partir do '%'. Copia em spec
+// os flags, largura e precisão (descartando modificadores de tamanho) seguidos
+// da conversão e retorna o ponteiro após ela.
+static const char *parse_spec(const char *p, char *spec, size_t len, char *conv) {
+    size_t n = 0;
+    spec[n++] = *p++; // '%'
+    while (*p && !strchr("diouxXcfFeEgGaA%", *p)) {
+        if (!strchr("hlLqjzt", *p) && n < len - 2) {
+            spec[n++] = *p;
+        }
+        p++;
+    }
+    *conv = *p;
+    if (*p) {
+        spec[n++] = *p++;
+    }
+    spec[n] = '\0';
+    return p;
+}
+
+unsigned dlog_count_args(const char *fmt) {
+    unsigned n = 0;
+    char spec[16], conv;
+    while (fmt && *fmt) {
+        if (*fmt != '%') {
+            fmt++;
+            continue;
+        }
+        fmt = parse_spec(fmt, spec, sizeof(spec), &conv);
+        if (conv && conv != '%') n++;
+    }
+    return n;
+}
+
+int dlog_format(const dlog_record_t *rec, char *buf, size_t len) {
+    const char *fmt = dlog_fmt(rec->id);
+    if (!fmt) {
+        return snprintf(buf, len, "<formato desconhecido %u>", rec->id);
+    }
+
+    size_t used = 0;
+    unsigned arg = 0;
+    char spec[16], conv;
+    while (*fmt && used + 1 < len) {
+        if (*fmt != '%') {
+            buf[used++] = *fmt++;
+            continue;
+        }
+        fmt = parse_spec(fmt, spec, sizeof(spec), &conv);
+        int n;
+        if (conv == '%' || conv == '\0') {
+            n = snprintf(buf + used, len - used, "%%");
+        } else if (arg >= rec->nargs) {
+            n = snprintf(buf + used, len - used, "<?>");
+        } else if (strchr("fFeEgGaA", conv)) {
+            float f;
+            memcpy(&f, &rec->args[arg++], sizeof(f));
+            n = snprintf(buf + used, len - used, spec, (double)f);
+        } else if (strchr("di", conv)) {
+            n = snprintf(buf + used, len - used, spec, (int)(int32_t)rec->args[arg++]);
+        } else {
+            n = snprintf(buf + used, len - used, spec, (unsigned)rec->args[arg++]);
+        }
+        if (n < 0) break;
+        used += (size_t)n < len - used ? (size_t)n : len - used - 1;
+    }
+    buf[used] = '\0';
+    return used;
+}
@@ -0,0 +1,23 @@
+// Tabela de formatos do log diferido (X-macro, incluída sem guarda).
+// DLOG_FORMAT(ID, nível, tag, formato)
+//   nível: E, W, I, D ou V, como no ESP_LOG
+//   formato: conversões inteiras (%d, %u, %x, %c) e de ponto flutuante (%f, %g);
+//   %s não é suportado, pois o argumento é decodificado depois, fora do contexto.
+// Novos formatos devem ser acrescentados no fim, para manter os IDs de dumps
+// binários antigos (DLOG_LEITURA e DLOG_DHT_FALHA não são mais usados desde a
+// tabela de sensores, mas continuam na tabela pelo mesmo motivo).
+
+DLOG_FORMAT(DLOG_DROPPED, W, "dlog", "%u registros de log descartados (anel cheio)")
+DLOG_FORMAT(DLOG_LEITURA, I, "ESTACAO_DISPLAY", "Temperatura:%.1f | Umidade:%.1f | Chuva:%d%% | KY028:%.0f | luminosidade:%d%%")
+DLOG_FORMAT(DLOG_DHT_FALHA, E, "ESTACAO_DISPLAY", "Falha ao ler o sensor DHT!")
+DLOG_FORMAT(DLOG_DHT_PHASE_B, E, "dht", "Initialization error, problem in phase 'B'")
+DLOG_FORMAT(DLOG_DHT_PHASE_C, E, "dht", "Initialization error, problem in phase 'C'")
+DLOG_FORMAT(DLOG_DHT_PHASE_D, E, "dht", "Initialization error, problem in phase 'D'")
+DLOG_FORMAT(DLOG_DHT_LOW_TIMEOUT, E, "dht", "LOW bit timeout")
+DLOG_FORMAT(DLOG_DHT_HIGH_TIMEOUT, E, "dht", "HIGH bit timeout")
+DLOG_FORMAT(DLOG_DHT_CRC, E, "dht", "Checksum failed, invalid data received from sensor")
+DLOG_FORMAT(DLOG_DHT_DATA, D, "dht", "Sensor data: humidity=%d, temp=%d")
+DLOG_FORMAT(DLOG_SENSOR_EVENTO, I, "ESTACAO_DISPLAY", "Evento: início de chuva=%d | mudança de luz=%d | leituras no período:%u")
+DLOG_FORMAT(DLOG_SENSOR_LEITURA, I, "SENSORES", "linha %u: %.1f (bruto %d)")
+DLOG_FORMAT(DLOG_SENSOR_ADC_FALHA, E, "SENSORES", "Falha ao ler o canal %d do ADC1!")
+DLOG_FORMAT(DLOG_SENSOR_DHT_FALHA, E, "SENSORES", "Falha ao ler o sensor DHT no GPIO %d!")
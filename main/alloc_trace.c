@@ -0,0 +1,77 @@
+#include "alloc_trace.h"
+
+#if CONFIG_STATION_ALLOC_TRACE
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+// Detalhes de uma alocação feita em regime permanente
+typedef struct {
+    void *ptr;
+    size_t size;
+    uint32_t caps;
+    TaskHandle_t task;   // Tarefa que alocou (NULL antes do escalonador)
+} alloc_record_t;
+
+static const char *TAG = "ALLOC_TRACE";
+
+static atomic_bool s_steady;                 // true após alloc_trace_mark_steady()
+static atomic_uint s_allocs;                 // Alocações em regime permanente
+static atomic_uint s_frees;                  // Liberações em regime permanente
+static atomic_uint s_bytes;                  // Bytes alocados em regime permanente
+static atomic_uint s_next;                   // Próxima posição no anel de registros
+static unsigned s_reported;                  // Registros já escritos no log
+static alloc_record_t s_records[CONFIG_STATION_ALLOC_TRACE_RECORDS];
+
+// Ganchos chamados pelo alocador do ESP-IDF. Rodam dentro do heap, portanto
+// não podem alocar, bloquear nem escrever no log: apenas contam e registram.
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (!atomic_load(&s_steady)) return;
+    atomic_fetch_add(&s_allocs, 1);
+    atomic_fetch_add(&s_bytes, size);
+    unsigned i = atomic_fetch_add(&s_next, 1) % CONFIG_STATION_ALLOC_TRACE_RECORDS;
+    s_records[i] = (alloc_record_t){
+        .ptr = ptr,
+        .size = size,
+        .caps = caps,
+        .task = xTaskGetCurrentTaskHandle(),
+    };
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) {
+    (void)ptr;
+    if (atomic_load(&s_steady)) {
+        atomic_fetch_add(&s_frees, 1);
+    }
+}
+
+void alloc_trace_mark_steady(void) {
+    ESP_LOGI(TAG, "Inicialização concluída, heap livre:%u bytes. Rastreando alocações...",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    atomic_store(&s_steady, true);
+}
+
+void alloc_trace_report(void) {
+    unsigned next = atomic_load(&s_next);
+    if (next == s_reported) return; // Nenhuma alocação nova: nada a relatar
+
+    ESP_LOGW(TAG, "Alocações em regime permanente:%u (%u bytes) | liberações:%u",
+             atomic_load(&s_allocs), atomic_load(&s_bytes), atomic_load(&s_frees));
+
+    // Registros mais antigos que o tamanho do anel já foram sobrescritos
+    if (next - s_reported > CONFIG_STATION_ALLOC_TRACE_RECORDS) {
+        s_reported = next - CONFIG_STATION_ALLOC_TRACE_RECORDS;
+    }
+    for (; s_reported != next; s_reported++) {
+        const alloc_record_t *r = &s_records[s_reported % CONFIG_STATION_ALLOC_TRACE_RECORDS];
+        ESP_LOGW(TAG, "  %u bytes em %p (caps 0x%lx) pela tarefa %s", (unsigned)r->size, r->ptr,
+                 (unsigned long)r->caps, r->task ? pcTaskGetName(r->task) : "?");
+    }
+}
+
+#endif // CONFIG_STATION_ALLOC_TRACE
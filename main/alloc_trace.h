@@ -0,0 +1,25 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include "sdkconfig.h"
+
+// Rastreador de alocações em regime permanente. Usa os ganchos de heap do
+// ESP-IDF (CONFIG_HEAP_USE_HOOKS) para registrar toda alocação feita depois
+// de alloc_trace_mark_steady(); fora desse modo as chamadas não fazem nada.
+
+#if CONFIG_STATION_ALLOC_TRACE
+
+// Marca o fim da inicialização: alocações a partir daqui são registradas
+void alloc_trace_mark_steady(void);
+
+// Escreve no log as alocações registradas desde o último relatório
+void alloc_trace_report(void);
+
+#else
+
+static inline void alloc_trace_mark_steady(void) {}
+static inline void alloc_trace_report(void) {}
+
+#endif
+
+#endif // ALLOC_TRACE_H
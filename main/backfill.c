@@ -0,0 +1,76 @@
+#include "backfill.h"
+
+#include "sdkconfig.h"
+#include "tsblock.h"
+
+#define NBLOCKS CONFIG_STATION_BACKFILL_BLOCKS
+
+static uint8_t s_blocks[NBLOCKS][CONFIG_STATION_BACKFILL_BLOCK_SIZE];
+static size_t s_lens[NBLOCKS];      // Tamanho de cada bloco fechado
+static unsigned s_first;            // Bloco fechado mais antigo
+static unsigned s_count;            // Blocos fechados
+static bool s_open;                 // Há um bloco aberto em (s_first + s_count) % NBLOCKS
+static tsblock_encoder_t s_enc;
+static unsigned s_pending;          // Amostras em blocos fechados e no aberto
+
+static unsigned block_samples(unsigned slot) {
+    return s_blocks[slot][2] | (s_blocks[slot][3] << 8);
+}
+
+// Fecha o bloco aberto, tornando-o disponível para publicação
+static void close_block(void) {
+    unsigned slot = (s_first + s_count) % NBLOCKS;
+    s_lens[slot] = tsblock_finish(&s_enc);
+    s_count++;
+    s_open = false;
+}
+
+// Abre um novo bloco, descartando o mais antigo se o anel estiver cheio
+static unsigned open_block(void) {
+    unsigned lost = 0;
+    if (s_count == NBLOCKS) {
+        lost = block_samples(s_first);
+        s_pending -= lost;
+        s_first = (s_first + 1) % NBLOCKS;
+        s_count--;
+    }
+    unsigned slot = (s_first + s_count) % NBLOCKS;
+    tsblock_encoder_init(&s_enc, s_blocks[slot], CONFIG_STATION_BACKFILL_BLOCK_SIZE);
+    s_open = true;
+    return lost;
+}
+
+unsigned backfill_push(const station_sample_t *sample) {
+    unsigned lost = 0;
+    if (!s_open) {
+        lost += open_block();
+    }
+    if (!tsblock_append(&s_enc, sample)) {
+        // Bloco cheio: fecha e continua num novo
+        close_block();
+        lost += open_block();
+        tsblock_append(&s_enc, sample);
+    }
+    s_pending++;
+    return lost;
+}
+
+const uint8_t *backfill_peek(size_t *len, bool flush) {
+    if (s_count == 0 && flush && s_open && s_enc.count > 0) {
+        close_block();
+    }
+    if (s_count == 0) return NULL;
+    *len = s_lens[s_first];
+    return s_blocks[s_first];
+}
+
+void backfill_pop(void) {
+    if (s_count == 0) return;
+    s_pending -= block_samples(s_first);
+    s_first = (s_first + 1) % NBLOCKS;
+    s_count--;
+}
+
+unsigned backfill_pending(void) {
+    return s_pending;
+}
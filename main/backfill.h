@@ -0,0 +1,29 @@
+#ifndef BACKFILL_H
+#define BACKFILL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "station.h"
+
+// Histórico comprimido para backfill: amostras que não puderam ser publicadas
+// são comprimidas (tsblock) num anel de blocos de tamanho fixo em RAM estática
+// e reenviadas em lote quando o broker volta. Não é thread-safe: deve ser usado
+// apenas pela uplink_task.
+
+// Comprime uma amostra no bloco aberto. Se o anel estiver cheio, o bloco mais
+// antigo é descartado; retorna o número de amostras perdidas (normalmente 0).
+unsigned backfill_push(const station_sample_t *sample);
+
+// Retorna o bloco pendente mais antigo (NULL se não houver). Com flush, o bloco
+// ainda aberto é fechado para que o histórico possa ser esvaziado por completo.
+const uint8_t *backfill_peek(size_t *len, bool flush);
+
+// Remove o bloco retornado por backfill_peek() após ele ser publicado
+void backfill_pop(void);
+
+// Amostras aguardando envio (blocos fechados e bloco aberto)
+unsigned backfill_pending(void);
+
+#endif // BACKFILL_H
@@ -0,0 +1,42 @@
+#include "history.h"
+
+#include <stdatomic.h>
+
+static station_sample_t s_ring[HISTORY_LEN];
+static atomic_uint_least32_t s_count;   // Amostras publicadas no anel
+
+void history_push(const station_sample_t *sample) {
+    uint32_t c = atomic_load_explicit(&s_count, memory_order_relaxed);
+    s_ring[c % HISTORY_LEN] = *sample;
+    // Publica a amostra somente depois de gravada por completo
+    atomic_store_explicit(&s_count, c + 1, memory_order_release);
+}
+
+uint32_t history_count(void) {
+    return atomic_load_explicit(&s_count, memory_order_acquire);
+}
+
+uint32_t history_oldest(uint32_t guard) {
+    uint32_t c = history_count();
+    uint32_t keep = HISTORY_LEN > guard ? HISTORY_LEN - guard : 1;
+    return c > keep ? c - keep : 0;
+}
+
+bool history_valid(uint32_t index) {
+    // O escritor pode estar gravando o índice history_count(), que ocupa a
+    // mesma posição de index - HISTORY_LEN; por isso a margem estrita
+    return index + HISTORY_LEN > history_count();
+}
+
+bool history_get(uint32_t index, station_sample_t *out) {
+    if (index >= history_count()) return false;
+    *out = s_ring[index % HISTORY_LEN];
+    return history_valid(index);
+}
+
+const station_sample_t *history_span(uint32_t index, uint32_t max, uint32_t *n) {
+    uint32_t pos = index % HISTORY_LEN;
+    uint32_t contiguous = HISTORY_LEN - pos;
+    *n = contiguous < max ? contiguous : max;
+    return &s_ring[pos];
+}
@@ -0,0 +1,43 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "station.h"
+
+// Histórico recente de amostras em RAM: anel de tamanho fixo com um único
+// escritor (station_task) e leitores sem trava (servidor HTTP). Cada amostra
+// recebe um índice absoluto crescente; um leitor copia a amostra e confirma
+// em seguida que ela não foi sobrescrita. Código C puro, usado também no host.
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#define HISTORY_LEN CONFIG_STATION_HISTORY_LEN
+
+// Acrescenta uma amostra (apenas a station_task escreve). Nunca bloqueia.
+void history_push(const station_sample_t *sample);
+
+// Total de amostras já gravadas; o índice da mais recente é history_count() - 1
+uint32_t history_count(void);
+
+// Índice da amostra mais antiga que ainda pode ser lida com segurança,
+// deixando `guard` posições de folga antes do ponto de escrita
+uint32_t history_oldest(uint32_t guard);
+
+// Copia a amostra de índice `index`. Retorna false se ela ainda não existe ou
+// já foi sobrescrita.
+bool history_get(uint32_t index, station_sample_t *out);
+
+// Acesso direto (sem cópia) ao trecho contíguo do anel que começa em `index`.
+// Retorna o ponteiro e em *n quantas amostras seguem contíguas, limitado a max.
+// O chamador deve confirmar com history_valid() depois de usar os dados.
+const station_sample_t *history_span(uint32_t index, uint32_t max, uint32_t *n);
+
+// true se a amostra `index` ainda não foi sobrescrita
+bool history_valid(uint32_t index);
+
+#endif // HISTORY_H
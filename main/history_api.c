@@ -0,0 +1,153 @@
+#include "history_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rollup.h"
+
+#define JSON_CHUNK (2 * STATION_JSON_MAX)  // Amostras são agrupadas em chunks de até este tamanho
+
+static uint32_t s_boot_id;
+
+void history_api_init(uint32_t boot_id) {
+    s_boot_id = boot_id;
+}
+
+void history_api_snapshot(history_snapshot_t *snap) {
+    snap->end = history_count();
+    // O boot e o total de amostras identificam unicamente o conteúdo atual do histórico
+    snprintf(snap->etag, sizeof(snap->etag), "W/\"%08lx-%lu\"", (unsigned long)s_boot_id,
+             (unsigned long)snap->end);
+}
+
+bool history_api_not_modified(const history_snapshot_t *snap, const char *if_none_match) {
+    return if_none_match && snap->end > 0 && strstr(if_none_match, snap->etag + 2) != NULL;
+}
+
+// Lê o parâmetro numérico `name` ("n=", "s=", ...) da query string
+static unsigned long query_ul(const char *query, const char *name, unsigned long def) {
+    const char *p = query;
+    size_t len = strlen(name);
+    while (p && (p = strstr(p, name)) != NULL) {
+        if (p == query || p[-1] == '&') return strtoul(p + len, NULL, 10);
+        p += len;
+    }
+    return def;
+}
+
+uint32_t history_api_parse_n(const char *query) {
+    unsigned long n = query_ul(query, "n=", HISTORY_LEN);
+    return (n == 0 || n > HISTORY_LEN) ? HISTORY_LEN : (uint32_t)n;
+}
+
+// Primeiro índice a enviar para as últimas n amostras da fotografia
+static uint32_t first_index(const history_snapshot_t *snap, uint32_t n) {
+    uint32_t oldest = history_oldest(HISTORY_API_GUARD);
+    uint32_t first = snap->end > n ? snap->end - n : 0;
+    return first > oldest ? first : oldest;
+}
+
+int history_api_latest(const history_snapshot_t *snap, history_write_fn w, void *ctx) {
+    station_sample_t s;
+    if (snap->end == 0 || !history_get(snap->end - 1, &s)) return 1;
+    char buf[STATION_JSON_MAX];
+    int len = station_format_json(buf, sizeof(buf), &s);
+    return w(ctx, buf, len) == 0 ? 0 : -1;
+}
+
+int history_api_json(const history_snapshot_t *snap, uint32_t n, history_write_fn w, void *ctx) {
+    char buf[JSON_CHUNK];
+    size_t used = 0;
+    bool first = true;
+    buf[used++] = '[';
+    for (uint32_t i = first_index(snap, n); i < snap->end; i++) {
+        station_sample_t s;
+        if (!history_get(i, &s)) return -1; // Sobrescrita durante o envio
+        if (!first) {
+            buf[used++] = ',';
+        }
+        first = false;
+        // Formata direto no buffer do chunk; se não couber, envia o chunk e recomeça
+        int len = station_format_json(buf + used, sizeof(buf) - used - 1, &s);
+        if (used + len + 1 >= sizeof(buf)) {
+            if (w(ctx, buf, used) != 0) return -1;
+            used = 0;
+            len = station_format_json(buf, sizeof(buf) - 1, &s);
+        }
+        used += len;
+    }
+    buf[used++] = ']';
+    return w(ctx, buf, used) == 0 ? 0 : -1;
+}
+
+int history_api_binary(const history_snapshot_t *snap, uint32_t n, history_write_fn w, void *ctx) {
+    uint32_t i = first_index(snap, n);
+    while (i < snap->end) {
+        uint32_t count;
+        const station_sample_t *span = history_span(i, snap->end - i, &count);
+        if (w(ctx, span, count * sizeof(*span)) != 0) return -1;
+        // O trecho foi enviado direto do anel; se o escritor o alcançou nesse
+        // meio tempo os dados podem estar corrompidos e a resposta é abortada
+        if (!history_valid(i)) return -1;
+        i += count;
+    }
+    return 0;
+}
+
+// Estado da resposta de /rollup entre as chamadas do visitante
+typedef struct {
+    history_write_fn w;
+    void *ctx;
+    size_t used;
+    bool first;
+    char buf[JSON_CHUNK];
+} rollup_out_t;
+
+static int rollup_append(rollup_out_t *o, const char *data, size_t len) {
+    if (o->used + len > sizeof(o->buf)) {
+        if (o->w(o->ctx, o->buf, o->used) != 0) return -1;
+        o->used = 0;
+    }
+    memcpy(o->buf + o->used, data, len);
+    o->used += len;
+    return 0;
+}
+
+static int rollup_visit(void *ctx, const rollup_bucket_t *b) {
+    rollup_out_t *o = ctx;
+    char item[32 + 48 * STATION_FIELD_COUNT];
+    int len = snprintf(item, sizeof(item), "%s{\"ts\":%lld,\"n\":%u", o->first ? "" : ",",
+                       (long long)b->start_s * 1000, b->count);
+    o->first = false;
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        const char *key = station_fields[f].key;
+        if (b->n[f]) {
+            len += snprintf(item + len, sizeof(item) - len, ",\"%s\":[%g,%g,%g]", key,
+                            rollup_value(f, b->min[f]), rollup_value(f, b->mean[f]), rollup_value(f, b->max[f]));
+        } else {
+            len += snprintf(item + len, sizeof(item) - len, ",\"%s\":null", key);
+        }
+    }
+    item[len++] = '}';
+    return rollup_append(o, item, len);
+}
+
+int history_api_rollup(const history_snapshot_t *snap, const char *query, history_write_fn w, void *ctx) {
+    station_sample_t s;
+    if (snap->end == 0 || !history_get(snap->end - 1, &s)) return 1;
+
+    // O intervalo termina na amostra mais recente da fotografia
+    uint32_t to_s = (uint32_t)(s.timestamp_ms / 1000);
+    unsigned long span = query_ul(query, "s=", 3600);
+    uint32_t from_s = span < to_s ? to_s - span : 0;
+    uint32_t points = query_ul(query, "points=", 0);
+    rollup_tier_t tier = rollup_pick(from_s, to_s, points);
+
+    rollup_out_t o = {.w = w, .ctx = ctx, .first = true};
+    o.used = snprintf(o.buf, sizeof(o.buf), "{\"tier\":\"%s\",\"period\":%lu,\"data\":[",
+                      rollup_tier_name(tier), (unsigned long)rollup_period_s(tier));
+    if (rollup_query(tier, from_s, to_s, rollup_visit, &o) != 0) return -1;
+    if (rollup_append(&o, "]}", 2) != 0) return -1;
+    return w(ctx, o.buf, o.used) == 0 ? 0 : -1;
+}
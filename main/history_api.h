@@ -0,0 +1,55 @@
+#ifndef HISTORY_API_H
+#define HISTORY_API_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "history.h"
+
+// Geração das respostas HTTP do histórico, independente do servidor usado.
+// O firmware liga estas funções ao esp_http_server (http_api.c) e a ferramenta
+// tools/history_http_host.c a um socket POSIX, para testes no computador.
+//
+// Rotas:
+//   /latest       última amostra, no mesmo JSON do tópico de dados
+//   /history?n=N  últimas N amostras em JSON (array), enviadas em chunks
+//   /history.bin  últimas N amostras como station_sample_t brutos, enviados
+//                 diretamente do anel, sem cópia
+//   /rollup?s=S&points=P  mínimo, média e máximo dos últimos S segundos
+//                 (padrão 3600) no nível de rollup.h escolhido por
+//                 rollup_pick(), com no máximo P intervalos (0 = sem limite)
+
+#define HISTORY_API_ETAG_LEN 32
+#define HISTORY_API_GUARD    2       // Folga em amostras antes do ponto de escrita
+
+// Envia um trecho da resposta; retorna 0 em caso de sucesso
+typedef int (*history_write_fn)(void *ctx, const void *data, size_t len);
+
+// Fotografia do histórico no início de uma requisição
+typedef struct {
+    uint32_t end;                       // Índice após a amostra mais recente
+    char etag[HISTORY_API_ETAG_LEN];    // Validador da resposta
+} history_snapshot_t;
+
+// Define o identificador desta inicialização (aleatório), que entra no ETag:
+// o total de amostras recomeça do zero a cada boot e sozinho repetiria ETags
+// de conteúdos diferentes
+void history_api_init(uint32_t boot_id);
+
+void history_api_snapshot(history_snapshot_t *snap);
+
+// true se o cabeçalho If-None-Match já contém o ETag atual (responder 304)
+bool history_api_not_modified(const history_snapshot_t *snap, const char *if_none_match);
+
+// Lê o parâmetro n da query string (padrão: histórico inteiro)
+uint32_t history_api_parse_n(const char *query);
+
+// Geradores das rotas. Retornam 0 em sucesso, 1 se não há amostras (404)
+// e -1 se a escrita falhou ou os dados foram sobrescritos durante o envio.
+int history_api_latest(const history_snapshot_t *snap, history_write_fn w, void *ctx);
+int history_api_json(const history_snapshot_t *snap, uint32_t n, history_write_fn w, void *ctx);
+int history_api_binary(const history_snapshot_t *snap, uint32_t n, history_write_fn w, void *ctx);
+int history_api_rollup(const history_snapshot_t *snap, const char *query, history_write_fn w, void *ctx);
+
+#endif // HISTORY_API_H
@@ -0,0 +1,117 @@
+#include "http_api.h"
+
+#if CONFIG_STATION_HTTP_ENABLE
+
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "history_api.h"
+
+#define HTTP_QUERY_MAX 128   // Maior query string aceita, com o terminador
+
+typedef enum {
+    ROUTE_LATEST,
+    ROUTE_HISTORY_JSON,
+    ROUTE_HISTORY_BIN,
+    ROUTE_ROLLUP,
+} route_t;
+
+static const char *TAG = "HTTP_API";
+static httpd_handle_t s_server;
+
+// Liga os geradores de history_api.c ao envio em chunks do esp_http_server
+static int send_chunk(void *ctx, const void *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK ? 0 : -1;
+}
+
+// Manipulador único das rotas; a rota vem em user_ctx
+static esp_err_t history_handler(httpd_req_t *req) {
+    route_t route = (route_t)(intptr_t)req->user_ctx;
+
+    history_snapshot_t snap;
+    history_api_snapshot(&snap);
+    httpd_resp_set_hdr(req, "ETag", snap.etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    // Requisição condicional: nada mudou desde a última consulta do cliente
+    char if_none_match[HISTORY_API_ETAG_LEN];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        history_api_not_modified(&snap, if_none_match)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    char query[HTTP_QUERY_MAX] = "";
+    uint32_t n = HISTORY_LEN;
+    esp_err_t qerr = httpd_req_get_url_query_str(req, query, sizeof(query));
+    if (qerr == ESP_ERR_HTTPD_RESULT_TRUNC) {
+        // Uma query cortada ainda seria lida, com parâmetros errados
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Query string longa demais");
+    }
+    if (qerr == ESP_OK) {
+        n = history_api_parse_n(query);
+    }
+
+    int res;
+    switch (route) {
+        case ROUTE_LATEST:
+            httpd_resp_set_type(req, "application/json");
+            res = history_api_latest(&snap, send_chunk, req);
+            break;
+        case ROUTE_HISTORY_JSON:
+            httpd_resp_set_type(req, "application/json");
+            res = history_api_json(&snap, n, send_chunk, req);
+            break;
+        case ROUTE_ROLLUP:
+            httpd_resp_set_type(req, "application/json");
+            res = history_api_rollup(&snap, query, send_chunk, req);
+            break;
+        default:
+            httpd_resp_set_type(req, "application/octet-stream");
+            res = history_api_binary(&snap, n, send_chunk, req);
+            break;
+    }
+
+    if (res > 0) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Nenhuma amostra disponivel");
+    }
+    if (res < 0) {
+        return ESP_FAIL; // Fecha a conexão: a resposta ficou incompleta
+    }
+    return httpd_resp_send_chunk(req, NULL, 0); // Finaliza a resposta chunked
+}
+
+void http_api_start(void) {
+    if (s_server) return;
+    history_api_init(esp_random());
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_STATION_HTTP_PORT;
+    if (httpd_start(&s_server, &config) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar o servidor HTTP!");
+        s_server = NULL;
+        return;
+    }
+
+    static const struct {
+        const char *uri;
+        route_t route;
+    } routes[] = {
+        {"/latest", ROUTE_LATEST},
+        {"/history", ROUTE_HISTORY_JSON},
+        {"/history.bin", ROUTE_HISTORY_BIN},
+        {"/rollup", ROUTE_ROLLUP},
+    };
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+        httpd_uri_t uri = {
+            .uri = routes[i].uri,
+            .method = HTTP_GET,
+            .handler = history_handler,
+            .user_ctx = (void *)(intptr_t)routes[i].route,
+        };
+        httpd_register_uri_handler(s_server, &uri);
+    }
+    ESP_LOGI(TAG, "Servidor HTTP iniciado na porta %d", config.server_port);
+}
+
+#endif // CONFIG_STATION_HTTP_ENABLE
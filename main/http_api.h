@@ -0,0 +1,20 @@
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include "sdkconfig.h"
+
+// Servidor HTTP local com a última leitura e o histórico em RAM, para que
+// ferramentas na rede local tenham acesso aos dados mesmo sem o broker MQTT.
+
+#if CONFIG_STATION_HTTP_ENABLE
+
+// Inicia o servidor (chamadas repetidas são ignoradas)
+void http_api_start(void);
+
+#else
+
+static inline void http_api_start(void) {}
+
+#endif
+
+#endif // HTTP_API_H
@@ -0,0 +1,28 @@
+#include "latency.h"
+
+void latency_hist_add(latency_hist_t *h, uint32_t ms) {
+    unsigned bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && ms >= (1u << bucket)) {
+        bucket++;
+    }
+    h->counts[bucket]++;
+    h->total++;
+    if (ms > h->max_ms) {
+        h->max_ms = ms;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *h, unsigned pct) {
+    if (h->total == 0) return 0;
+    // Posição (arredondada para cima) da amostra do percentil
+    uint64_t rank = ((uint64_t)h->total * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < LATENCY_BUCKETS - 1; b++) {
+        seen += h->counts[b];
+        if (seen >= rank && seen > 0) {
+            uint32_t upper = 1u << b;
+            return upper < h->max_ms ? upper : h->max_ms;
+        }
+    }
+    return h->max_ms;
+}
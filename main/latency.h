@@ -0,0 +1,25 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+// Histograma de latências em faixas logarítmicas (potências de 2 em ms).
+// A faixa 0 conta latências < 1 ms, a faixa k conta [2^(k-1), 2^k) ms e a
+// última acumula tudo acima. Código C puro, sem sincronização própria.
+
+#define LATENCY_BUCKETS 20   // Até ~4,4 min na última faixa limitada
+
+typedef struct {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint32_t total;
+    uint32_t max_ms;
+} latency_hist_t;
+
+// Registra uma latência em ms
+void latency_hist_add(latency_hist_t *h, uint32_t ms);
+
+// Estimativa do percentil pct (0-100): limite superior da faixa que o contém.
+// Retorna 0 se o histograma estiver vazio.
+uint32_t latency_hist_percentile(const latency_hist_t *h, unsigned pct);
+
+#endif // LATENCY_H
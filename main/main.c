@@ -20,11 +20,24 @@
 #include "esp_event.h"      // Para o loop de eventos
 #include "nvs_flash.h"      // Para armazenamento não-volátil (necessário para o Wi-Fi)
 #include "esp_netif.h"      // Para a interface de rede
+#include "esp_timer.h"      // Para o timestamp das amostras
+#include "esp_pm.h"         // Travas de gerenciamento de energia
 
 //  Inclusão de bibliotecas de aplicação
 #include "mqtt_client.h"    // Para o cliente MQTT
-#include "dht.h"            // Para o sensor de temperatura e umidade DHT11/22
+#include "dlog.h"           // Log diferido: registra sem esperar pela UART
 #include "font8x8_basic.h"  // Arquivo com a definição da fonte 8x8 ASCII para o display
+#include "station.h"        // Tipos compartilhados da estação (amostra dos sensores)
+#include "sensors.h"        // Tabela de sensores e leitura simultânea dos DHT
+#include "uplink.h"         // Publicador MQTT assíncrono com outbox limitado
+#include "alloc_trace.h"    // Rastreador de alocações em regime permanente
+#include "history.h"        // Histórico recente das leituras em RAM
+#include "rollup.h"         // Resumos por minuto e por hora do histórico
+#include "http_api.h"       // Servidor HTTP local com as leituras
+#include "mqtt_tls.h"       // Transporte TLS com retomada de sessão (mqtts://)
+#include "rain_detect.h"    // Limiares de início de chuva e mudança de luz
+#include "ulp_sense.h"      // Amostragem dos sensores analógicos pelo ULP
+#include "power.h"          // DFS, light sleep automático e ciclo de trabalho
 
 //  Configurações de Rede e MQTT
 #define WIFI_SSID         "Nome da rede WIFI"                   // Nome da sua rede Wi-Fi
@@ -32,13 +45,20 @@
 #define MQTT_BROKER_URI   "mqtt://IP SERVIDOR BROKER:1883"     // Endereço do seu broker MQTT
 #define MQTT_USER         "USUARIO"                   // Usuário do broker MQTT
 #define MQTT_PASS         "SENHA"                   // Senha do broker MQTT
+#define MQTT_BROKER_CA    NULL                      // CA do broker em PEM para mqtts:// (NULL usa o pacote de CAs do IDF)
 #define MQTT_TOPIC_DATA   "/ifpe/ads/embarcados/esp32/station/data" // Tópico para publicar os dados
-
-//  Mapeamento de Pinos dos Sensores
-#define DHT_PIN           GPIO_NUM_4                 // Pino para o sensor DHT11
-#define LDR_ADC_CHANNEL   ADC_CHANNEL_4              // Canal ADC para o LDR (GPIO32)
-#define CHUVA_ADC_CHANNEL ADC_CHANNEL_6              // Canal ADC para o sensor de chuva (GPIO34)
-#define KY028_ADC_CHANNEL ADC_CHANNEL_7              // Canal ADC para o sensor KY-028 (GPIO35)
+#define MQTT_TOPIC_BACKFILL "/ifpe/ads/embarcados/esp32/station/backfill" // Tópico do histórico comprimido
+
+//  Tabela de Sensores: cada linha alimenta um campo de station_fields.h (ver sensors.h).
+//  Para outra sonda, acrescente o campo em station_fields.h e a linha aqui.
+static const sensor_desc_t sensor_table[] = {
+    // tipo        pino/canal     grandeza                  período  conversão                campo
+    {SENSOR_DHT11, GPIO_NUM_4,    SENSOR_VALUE_TEMPERATURA, 0,       sensor_conv_tenths,      STATION_FIELD_TEMPERATURA},
+    {SENSOR_DHT11, GPIO_NUM_4,    SENSOR_VALUE_UMIDADE,     0,       sensor_conv_tenths,      STATION_FIELD_UMIDADE},
+    {SENSOR_ADC,   ADC_CHANNEL_6, SENSOR_VALUE_RAW,         0,       sensor_conv_percent_inv, STATION_FIELD_CHUVA},        // GPIO34
+    {SENSOR_ADC,   ADC_CHANNEL_7, SENSOR_VALUE_RAW,         0,       sensor_conv_raw,         STATION_FIELD_KY028},        // GPIO35
+    {SENSOR_ADC,   ADC_CHANNEL_4, SENSOR_VALUE_RAW,         0,       sensor_conv_percent_inv, STATION_FIELD_LUMINOSIDADE}, // LDR, GPIO32
+};
 
 //  Configurações do Display LCD (ST7735S)
 #define LCD_WIDTH         128                        // Largura do display em pixels
@@ -59,6 +79,15 @@ static const char *TAG = "ESTACAO_DISPLAY";       // Tag para logs no monitor se
 static adc_oneshot_unit_handle_t g_adc1_handle; // Handle para a unidade ADC1
 static esp_mqtt_client_handle_t client;         // Handle para o cliente MQTT
 static spi_device_handle_t spi;                 // Handle para o dispositivo SPI (display)
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t display_pm_lock;    // Mantém o APB no máximo durante o redesenho do display
+#endif
+
+#if CONFIG_STATION_STATIC_ALLOC
+// Pilha e controle da station_task reservados em tempo de compilação
+static StaticTask_t station_task_buf;
+static StackType_t station_task_stack[CONFIG_STATION_TASK_STACK];
+#endif
 
 
 
@@ -112,6 +141,9 @@ void lcd_init() {
         .queue_size = 7,
     };
     spi_bus_add_device(SPI2_HOST, &devcfg, &spi);
+#if CONFIG_PM_ENABLE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "display", &display_pm_lock));
+#endif
 
     // Sequência de inicialização do display ST7735S
     lcd_reset();
@@ -184,44 +216,36 @@ void fill_screen(uint16_t color) {
     }
 }
 
-// Formata e exibe os dados dos sensores no display
-void display_data(float temperatura, float umidade, int chuva, double ky028, int luminosidade) {
+// Formata e exibe os campos da amostra no display, na ordem de station_fields.h
+void display_sample(const station_sample_t *sample) {
     char buffer[64]; // Buffer para formatar as strings
+    char value[32];
+    // Rótulo e valor em linhas separadas enquanto couberem; senão, uma linha por campo
+    const bool two_lines = STATION_FIELD_COUNT * 30 <= LCD_HEIGHT - 10;
+#if CONFIG_PM_ENABLE
+    // Um redesenho são milhares de transações SPI curtas: segura o clock do
+    // barramento (e impede o light sleep) do início ao fim, em vez de a cada transação
+    esp_pm_lock_acquire(display_pm_lock);
+#endif
     fill_screen(COLOR_BLUE); // Limpa a tela com a cor azul
 
-    // Exibe Temperatura
-    sprintf(buffer, "Temperatura:");
-    draw_text(10, 10, buffer, COLOR_WHITE);
-    sprintf(buffer, "%.1f C", temperatura);
-    draw_text(10, 20, buffer, COLOR_WHITE);
-
-    // Exibe Umidade
-    sprintf(buffer, "Umidade:");
-    draw_text(10, 40, buffer, COLOR_WHITE);
-    sprintf(buffer, "%.1f %%", umidade);
-    draw_text(10, 50, buffer, COLOR_WHITE);
-    
-    // Exibe KY-028
-    sprintf(buffer, "KY-028:");
-    draw_text(10, 70, buffer, COLOR_WHITE);
-    sprintf(buffer, "%.0f", ky028); // Exibe o valor bruto do ADC
-    draw_text(10, 80, buffer, COLOR_WHITE);
-    
-    // Exibe Luminosidade
-    sprintf(buffer, "Luminosidade:");
-    draw_text(10, 100, buffer, COLOR_WHITE);
-    sprintf(buffer, "%d %%", luminosidade);
-    draw_text(10, 110, buffer, COLOR_WHITE);
-
-    // Exibe Chuva
-    sprintf(buffer, "Chuva:");
-    draw_text(10, 130, buffer, COLOR_WHITE);
-    sprintf(buffer, "%d %%", chuva);
-    draw_text(10, 140, buffer, COLOR_WHITE);
-
-    // Imprime os mesmos dados no log para depuração
-    ESP_LOGI(TAG, "Temperatura:%.1f | Umidade:%.1f | Chuva:%d%% | KY028:%.0f | luminosidade:%d%%",
-             temperatura, umidade, chuva, ky028, luminosidade);
+    uint8_t y = 10;
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        station_format_value(value, sizeof(value), sample, f);
+        if (two_lines) {
+            sprintf(buffer, "%s:", station_fields[f].label);
+            draw_text(10, y, buffer, COLOR_WHITE);
+            draw_text(10, y + 10, value, COLOR_WHITE);
+            y += 30;
+        } else {
+            snprintf(buffer, sizeof(buffer), "%s: %s", station_fields[f].label, value);
+            draw_text(0, y, buffer, COLOR_WHITE);
+            y += 10;
+        }
+    }
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(display_pm_lock);
+#endif
 }
 
 
@@ -234,14 +258,22 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     esp_mqtt_event_handle_t event = event_data;
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "MQTT conectado!");
+            ESP_LOGI(TAG, "MQTT conectado! (sessão no broker: %s)", event->session_present ? "retomada" : "nova");
+            uplink_set_connected(true);
             break;
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "MQTT desconectado!");
+            uplink_set_connected(false); // Amostras passam a ir para o backfill
             break;
         case MQTT_EVENT_ERROR:
             ESP_LOGE(TAG, "Erro no MQTT!");
             break;
+        case MQTT_EVENT_PUBLISHED:
+            uplink_on_published(event->msg_id); // PUBACK recebido do broker
+            break;
+        case MQTT_EVENT_DELETED:
+            uplink_on_deleted(event->msg_id);   // Mensagem expirou no outbox
+            break;
         default:
             break;
     }
@@ -249,16 +281,35 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
 
 // Configura e inicia o cliente MQTT
 static void mqtt_app_start(void) {
+    if (client) {
+        return; // O cliente já existente reconecta sozinho e mantém a sessão TLS guardada
+    }
     esp_mqtt_client_config_t mqtt_cfg = {
         .broker.address.uri = MQTT_BROKER_URI,
         .credentials = {
             .username = MQTT_USER,
             .authentication.password = MQTT_PASS,
         },
+        .outbox.limit = CONFIG_STATION_MQTT_OUTBOX_LIMIT, // Limita a memória usada pelo outbox
+#if CONFIG_MQTT_PROTOCOL_5
+        .session.protocol_ver = MQTT_PROTOCOL_V_5, // Aliases de tópico e propriedades por mensagem
+#endif
+#if CONFIG_STATION_MQTT_PERSISTENT_SESSION
+        .session.disable_clean_session = true, // Broker mantém a sessão entre conexões
+#endif
+        .network.transport = mqtt_tls_transport(MQTT_BROKER_URI, MQTT_BROKER_CA), // NULL: transporte padrão
     };
     client = esp_mqtt_client_init(&mqtt_cfg);
+#if CONFIG_MQTT_PROTOCOL_5 && CONFIG_STATION_MQTT_PERSISTENT_SESSION
+    // No MQTT 5 a sessão só sobrevive à desconexão com Session Expiry > 0
+    esp_mqtt5_connection_property_config_t conn_prop = {
+        .session_expiry_interval = CONFIG_STATION_MQTT5_SESSION_EXPIRY,
+    };
+    esp_mqtt5_client_set_connect_property(client, &conn_prop);
+#endif
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
     esp_mqtt_client_start(client);
+    uplink_set_client(client); // Libera o publicador para usar o novo cliente
 }
 
 // Manipulador de eventos para o Wi-Fi
@@ -270,6 +321,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ESP_LOGI(TAG, "Conectado ao Wi-Fi! Endereço IP obtido.");
         mqtt_app_start(); // Inicia o MQTT somente após obter um IP
+        http_api_start(); // Servidor HTTP local (independe do broker)
     }
 }
 
@@ -280,17 +332,16 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
 // Configura a unidade e os canais do ADC
 void setup_adc() {
     // Configura a unidade ADC1
-    adc_oneshot_unit_init_cfg_t init_config1 = {.unit_id = ADC_UNIT_1};
+    adc_oneshot_unit_init_cfg_t init_config1 = {
+        .unit_id = ADC_UNIT_1,
+#if CONFIG_STATION_ULP_SENSE
+        .ulp_mode = ADC_ULP_MODE_FSM, // Quem lê o ADC1 é o ULP (ulp_sense.c)
+#endif
+    };
     ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config1, &g_adc1_handle));
 
-    // Configura cada canal do ADC
-    adc_oneshot_chan_cfg_t config = {
-        .bitwidth = ADC_BITWIDTH_DEFAULT, // Resolução padrão (12 bits)
-        .atten = ADC_ATTEN_DB_12          // Atenuação para ler até ~3.3V
-    };
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(g_adc1_handle, LDR_ADC_CHANNEL, &config));
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(g_adc1_handle, CHUVA_ADC_CHANNEL, &config));
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(g_adc1_handle, KY028_ADC_CHANNEL, &config));
+    // Configura os canais da tabela de sensores
+    ESP_ERROR_CHECK(sensors_init(sensor_table, sizeof(sensor_table) / sizeof(sensor_table[0]), g_adc1_handle));
 }
 
 
@@ -299,42 +350,97 @@ void setup_adc() {
 
 
 void station_task(void *pvParameters) {
+    uint32_t seq = 0; // Número de sequência das amostras, para detectar perdas
+#if CONFIG_STATION_ULP_SENSE
+    static ulp_sense_reading_t ulp_readings[CONFIG_STATION_ULP_BUFFER_LEN];
+    // Chuva, LDR e KY-028 precisam ser linhas ADC da tabela; senão o canal é -1 e a partida falha
+    ESP_ERROR_CHECK(ulp_sense_start(xTaskGetCurrentTaskHandle(), sensors_adc_channel(STATION_FIELD_CHUVA),
+                                    sensors_adc_channel(STATION_FIELD_LUMINOSIDADE),
+                                    sensors_adc_channel(STATION_FIELD_KY028)));
+#else
+    // Mesmos limiares do ULP, aplicados às leituras dos núcleos principais
+    const rain_detect_cfg_t rain_cfg = {
+        .rain_on = CONFIG_STATION_RAIN_ON,
+        .rain_off = CONFIG_STATION_RAIN_OFF,
+        .light_delta = CONFIG_STATION_LIGHT_DELTA,
+    };
+    rain_detect_state_t rain_state = {0};
+#endif
+#if CONFIG_STATION_ALLOC_TRACE
+    // Prazos (ms) do fim da inicialização e do próximo relatório do rastreador,
+    // pelo relógio e não por ciclos: no modo ULP a duração do ciclo varia
+    int64_t alloc_steady_at = esp_timer_get_time() / 1000 + CONFIG_STATION_ALLOC_TRACE_WARMUP_S * 1000;
+    int64_t alloc_report_at = 0; // 0: ainda no aquecimento
+#endif
     while (1) { // Loop infinito da tarefa
-        float temperatura = 0, umidade = 0;
-        int luminosidade_raw = 0, chuva_raw = 0, ky028_raw = 0;
-
-        // Lê o sensor de temperatura e umidade DHT11
-        if (dht_read_float_data(DHT_TYPE_DHT11, DHT_PIN, &umidade, &temperatura) != ESP_OK) {
-            ESP_LOGE(TAG, "Falha ao ler o sensor DHT!");
-            temperatura = -1; umidade = -1; // Valores de erro
+        int64_t timestamp_ms = esp_timer_get_time() / 1000; // Instante da captura
+
+#if CONFIG_STATION_ULP_SENSE
+        // Leituras analógicas feitas pelo ULP desde o último ciclo: a chuva é a
+        // mais intensa do período; luz e KY-028, as mais recentes
+        unsigned events;
+        size_t n = ulp_sense_drain(ulp_readings, &events);
+        ulp_sense_reading_t latest;
+        ulp_sense_latest(&latest);
+        int chuva_raw = latest.chuva_raw;
+        for (size_t i = 0; i < n; i++) {
+            if (ulp_readings[i].chuva_raw < chuva_raw) chuva_raw = ulp_readings[i].chuva_raw;
         }
-
-        // Lê os sensores analógicos
-        adc_oneshot_read(g_adc1_handle, LDR_ADC_CHANNEL, &luminosidade_raw);
-        adc_oneshot_read(g_adc1_handle, CHUVA_ADC_CHANNEL, &chuva_raw);
-        adc_oneshot_read(g_adc1_handle, KY028_ADC_CHANNEL, &ky028_raw);
-
-        // Converte os valores brutos dos sensores de LDR e chuva para porcentagem.
-        // A lógica é invertida porque um valor ADC maior significa menos luz/chuva.
-        int ldr_percent = (int)(((4095.0 - luminosidade_raw) / 4095.0) * 100);
-        int chuva_percent = (int)(((4095.0 - chuva_raw) / 4095.0) * 100);
-
-        // Monta a string JSON com os dados dos sensores
-        char payload[256];
-        snprintf(payload, sizeof(payload),
-                 "{\"temperatura\":%.1f,\"umidade\":%.1f,\"chuva\":%d,\"ky028\":%d,\"luminosidade\":%d}",
-                 temperatura, umidade, chuva_percent, ky028_raw, ldr_percent);
-
-        // Publica os dados no tópico MQTT se o cliente estiver conectado
-        if (client) {
-            esp_mqtt_client_publish(client, MQTT_TOPIC_DATA, payload, 0, 1, 0);
+        sensors_store_raw(STATION_FIELD_CHUVA, chuva_raw);
+        sensors_store_raw(STATION_FIELD_LUMINOSIDADE, latest.ldr_raw);
+        sensors_store_raw(STATION_FIELD_KY028, latest.ky028_raw);
+#endif
+
+        // Lê os sensores vencidos da tabela (os DHT simultaneamente) e monta a amostra
+        station_sample_t sample = {
+            .timestamp_ms = timestamp_ms,
+            .seq = seq++,
+        };
+        sensors_read(&sample, timestamp_ms);
+
+#if !CONFIG_STATION_ULP_SENSE
+        // Limiares de chuva e luz sobre as leituras brutas (ignorados se uma delas falhou)
+        size_t n = 1;
+        int chuva_raw = sensors_raw(STATION_FIELD_CHUVA);
+        int ldr_raw = sensors_raw(STATION_FIELD_LUMINOSIDADE);
+        unsigned events = 0;
+        if (chuva_raw >= 0 && ldr_raw >= 0) {
+            events = rain_detect_step(&rain_state, &rain_cfg, chuva_raw, ldr_raw);
         }
+#endif
+        if (events) {
+            DLOG(DLOG_SENSOR_EVENTO, !!(events & RAIN_DETECT_EVENT_RAIN), !!(events & RAIN_DETECT_EVENT_LIGHT),
+                 (unsigned)n);
+        }
+
+        // Entrega a amostra ao publicador MQTT (nunca bloqueia a amostragem)
+        uplink_submit(&sample);
+        history_push(&sample); // Disponibiliza a leitura no histórico local
+        rollup_push(&sample);  // E nos resumos por minuto e por hora
 
         // Atualiza os dados no display
-        display_data(temperatura, umidade, chuva_percent, ky028_raw, ldr_percent);
+        display_sample(&sample);
+
+#if CONFIG_STATION_ALLOC_TRACE
+        // Após o aquecimento, qualquer alocação de heap é registrada e reportada a cada minuto
+        if (alloc_report_at == 0) {
+            if (timestamp_ms >= alloc_steady_at) {
+                alloc_trace_mark_steady();
+                alloc_report_at = timestamp_ms + 60 * 1000;
+            }
+        } else if (timestamp_ms >= alloc_report_at) {
+            alloc_report_at = timestamp_ms + 60 * 1000;
+            alloc_trace_report();
+        }
+#endif
 
+#if CONFIG_STATION_ULP_SENSE
+        // Dorme até o ULP detectar início de chuva ou mudança de luz, ou até o próximo relatório
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_STATION_ULP_REPORT_PERIOD_S * 1000));
+#else
         // Aguarda 5 segundos antes da próxima leitura
         vTaskDelay(pdMS_TO_TICKS(5000));
+#endif
     }
 }
 
@@ -343,6 +449,12 @@ void station_task(void *pvParameters) {
 
 
 void app_main(void) {
+    // 0. Inicia a tarefa do log diferido
+    dlog_start();
+
+    // 0.1. Ativa o DFS e o light sleep automático (se configurados)
+    power_init();
+
     // 1. Inicializa o NVS (Non-Volatile Storage) - necessário para o Wi-Fi
     ESP_ERROR_CHECK(nvs_flash_init());
     
@@ -374,12 +486,22 @@ void app_main(void) {
     // 7. Inicia o Wi-Fi
     ESP_ERROR_CHECK(esp_wifi_start());
     ESP_LOGI(TAG, "Wi-Fi inicializado. Aguardando conexão...");
+#if CONFIG_STATION_PM
+    // O rádio dorme entre os beacons do AP e mantém a associação durante o light sleep
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
+#endif
 
     // 8. Inicializa os periféricos
     lcd_init();      // Inicializa o display
     fill_screen(COLOR_BLACK); // Limpa a tela
     setup_adc();     // Inicializa o ADC
+    uplink_init(MQTT_TOPIC_DATA, MQTT_TOPIC_BACKFILL); // Inicia o publicador MQTT
 
     // 9. Cria e inicia a tarefa principal da estação
-    xTaskCreate(station_task, "station_task", 4096, NULL, 5, NULL);
+#if CONFIG_STATION_STATIC_ALLOC
+    xTaskCreateStatic(station_task, "station_task", CONFIG_STATION_TASK_STACK, NULL, 5,
+                      station_task_stack, &station_task_buf);
+#else
+    xTaskCreate(station_task, "station_task", CONFIG_STATION_TASK_STACK, NULL, 5, NULL);
+#endif
 }
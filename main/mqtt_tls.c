@@ -0,0 +1,213 @@
+#include "mqtt_tls.h"
+
+#if CONFIG_STATION_MQTT_TLS_RESUME
+
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "mbedtls/ssl.h"
+#include "latency.h"
+
+#define MQTTS_DEFAULT_PORT  8883
+#define RESUME_MAX_FAILURES 3       // Falhas seguidas oferecendo a sessão antes de descartá-la
+
+static const char *TAG = "MQTT_TLS";
+
+// Conexão atual; o cliente MQTT usa um único transporte, sempre na sua tarefa
+static esp_tls_t *s_tls;
+static const char *s_ca_pem;
+
+// Sessão da última conexão bem-sucedida, oferecida na próxima (só a tarefa do cliente MQTT usa)
+static esp_tls_client_session_t *s_session;
+static unsigned s_resume_failures;     // Falhas seguidas desde que a sessão passou a ser oferecida
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED; // Protege os contadores
+static uint32_t s_failures;
+static uint32_t s_offered;
+static latency_hist_t s_full_hist;
+static latency_hist_t s_resumed_hist;
+
+static void drop_session(void) {
+    if (s_session) {
+        esp_tls_free_client_session(s_session);
+        s_session = NULL;
+    }
+    s_resume_failures = 0;
+}
+
+// Indica se a sessão negociada é a retomada da sessão oferecida. Na retomada,
+// por ID ou por ticket, o broker reaproveita o segredo mestre da sessão
+// oferecida; o handshake completo sempre deriva um novo. O ID não serve para
+// isso: com um ticket o mbedtls oferece um ID aleatório, que não fica na sessão guardada.
+static bool same_session(const esp_tls_client_session_t *offered, const esp_tls_client_session_t *negotiated) {
+    const mbedtls_ssl_session *a = &offered->saved_session;
+    const mbedtls_ssl_session *b = &negotiated->saved_session;
+    return memcmp(a->MBEDTLS_PRIVATE(master), b->MBEDTLS_PRIVATE(master), sizeof(a->MBEDTLS_PRIVATE(master))) == 0;
+}
+
+static int tls_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms) {
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+        .cacert_buf = (const unsigned char *)s_ca_pem,
+        .cacert_bytes = s_ca_pem ? strlen(s_ca_pem) + 1 : 0,
+        .crt_bundle_attach = s_ca_pem ? NULL : esp_crt_bundle_attach,
+        .client_session = s_session,
+    };
+    bool resume = s_session != NULL;
+
+    s_tls = esp_tls_init();
+    if (!s_tls) return -1;
+    int64_t start = esp_timer_get_time();
+    if (esp_tls_conn_new_sync(host, strlen(host), port, &cfg, s_tls) <= 0) {
+        esp_tls_error_handle_t eh;
+        esp_err_t err = ESP_FAIL;
+        int tls_code = 0, tls_flags = 0;
+        if (esp_tls_get_error_handle(s_tls, &eh) == ESP_OK) {
+            err = esp_tls_get_and_clear_last_error(eh, &tls_code, &tls_flags);
+        }
+        esp_tls_conn_destroy(s_tls);
+        s_tls = NULL;
+        ESP_LOGW(TAG, "Falha na conexão TLS: %s (mbedtls -0x%04x)", esp_err_to_name(err), (unsigned)-tls_code);
+        // Uma sessão recusada pelo broker já cai no handshake completo dentro
+        // do mbedtls. Falhas de DNS, TCP ou Wi-Fi não dizem nada sobre a sessão,
+        // justamente nos links instáveis em que a retomada mais ajuda: ela só é
+        // descartada quando o próprio handshake falha ou após várias falhas seguidas.
+        if (resume && (err == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED || ++s_resume_failures >= RESUME_MAX_FAILURES)) {
+            drop_session();
+        }
+        taskENTER_CRITICAL(&s_lock);
+        s_failures++;
+        taskEXIT_CRITICAL(&s_lock);
+        return -1;
+    }
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+    // Oferecer a sessão não garante a retomada: o broker pode recusá-la e o
+    // mbedtls cai no handshake completo sem avisar. A sessão negociada é
+    // comparada com a oferecida; sem cópia da negociada a conexão conta como completa.
+    esp_tls_client_session_t *session = esp_tls_get_client_session(s_tls);
+    bool resumed = resume && session && same_session(s_session, session);
+
+    // Guarda a sessão (ou o ticket renovado) desta conexão para a próxima
+    if (session) {
+        drop_session();
+        s_session = session;
+    }
+    s_resume_failures = 0;
+
+    mqtt_tls_stats_t st;
+    taskENTER_CRITICAL(&s_lock);
+    s_offered += resume;
+    latency_hist_add(resumed ? &s_resumed_hist : &s_full_hist, ms);
+    taskEXIT_CRITICAL(&s_lock);
+    mqtt_tls_get_stats(&st);
+    ESP_LOGI(TAG, "Conexão TLS em %lu ms (%s) | completas:%lu p50:%lu max:%lu | "
+             "retomadas:%lu de %lu ofertas p50:%lu max:%lu",
+             (unsigned long)ms, resumed ? "sessão retomada" : resume ? "sessão recusada" : "handshake completo",
+             (unsigned long)st.full, (unsigned long)st.full_p50_ms, (unsigned long)st.full_max_ms,
+             (unsigned long)st.resumed, (unsigned long)st.offered, (unsigned long)st.resumed_p50_ms,
+             (unsigned long)st.resumed_max_ms);
+    return 0;
+}
+
+// Espera o socket ficar pronto para leitura ou escrita. Retorna 1 se pronto,
+// 0 no timeout e -1 em erro, como os demais transportes do IDF.
+static int tls_poll(int timeout_ms, bool write) {
+    if (!s_tls) return -1;
+    if (!write && esp_tls_get_bytes_avail(s_tls) > 0) {
+        return 1; // Dados já decifrados aguardando no buffer do TLS
+    }
+    int fd;
+    if (esp_tls_get_conn_sockfd(s_tls, &fd) != ESP_OK) return -1;
+
+    fd_set set, errset;
+    FD_ZERO(&set);
+    FD_ZERO(&errset);
+    FD_SET(fd, &set);
+    FD_SET(fd, &errset);
+    struct timeval tv = {.tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000};
+    int ret = select(fd + 1, write ? NULL : &set, write ? &set : NULL, &errset, timeout_ms < 0 ? NULL : &tv);
+    if (ret > 0 && FD_ISSET(fd, &errset)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        ESP_LOGE(TAG, "Erro no socket: %d (%s)", err, strerror(err));
+        return -1;
+    }
+    return ret;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(timeout_ms, false);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(timeout_ms, true);
+}
+
+static int tls_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms) {
+    int poll = tls_poll(timeout_ms, false);
+    if (poll <= 0) return poll;
+    int ret = esp_tls_conn_read(s_tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0; // Registro TLS incompleto: tenta de novo na próxima leitura
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN; // Socket pronto sem dados: o broker fechou
+    }
+    return ret < 0 ? -1 : ret;
+}
+
+static int tls_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms) {
+    int poll = tls_poll(timeout_ms, true);
+    if (poll <= 0) return poll;
+    int ret = esp_tls_conn_write(s_tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    return ret < 0 ? -1 : ret;
+}
+
+static int tls_close(esp_transport_handle_t t) {
+    if (s_tls) {
+        esp_tls_conn_destroy(s_tls);
+        s_tls = NULL;
+    }
+    return 0;
+}
+
+esp_transport_handle_t mqtt_tls_transport(const char *uri, const char *ca_pem) {
+    if (strncmp(uri, "mqtts://", 8) != 0) {
+        return NULL;
+    }
+    esp_transport_handle_t t = esp_transport_init();
+    if (!t) return NULL;
+    s_ca_pem = ca_pem;
+    esp_transport_set_func(t, tls_connect, tls_read, tls_write, tls_close,
+                           tls_poll_read, tls_poll_write, tls_close);
+    esp_transport_set_default_port(t, MQTTS_DEFAULT_PORT);
+    return t;
+}
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t *out) {
+    taskENTER_CRITICAL(&s_lock);
+    out->full = s_full_hist.total;
+    out->resumed = s_resumed_hist.total;
+    out->offered = s_offered;
+    out->failures = s_failures;
+    out->full_p50_ms = latency_hist_percentile(&s_full_hist, 50);
+    out->full_max_ms = s_full_hist.max_ms;
+    out->resumed_p50_ms = latency_hist_percentile(&s_resumed_hist, 50);
+    out->resumed_max_ms = s_resumed_hist.max_ms;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+#endif // CONFIG_STATION_MQTT_TLS_RESUME
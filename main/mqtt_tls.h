@@ -0,0 +1,45 @@
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <stdint.h>
+
+#include "esp_transport.h"
+#include "sdkconfig.h"
+
+// Transporte TLS do cliente MQTT com retomada de sessão: a sessão (ID ou ticket)
+// negociada na última conexão é guardada e oferecida ao broker na reconexão
+// seguinte, que dispensa a troca de certificados e a criptografia assimétrica
+// do handshake completo. Mede o tempo de cada conexão TLS, separando as
+// retomadas (sessão negociada igual à oferecida) dos handshakes completos.
+
+// Contadores e tempos de conexão (DNS + TCP + handshake TLS)
+typedef struct {
+    uint32_t full;              // Conexões com handshake completo (inclui sessões recusadas)
+    uint32_t resumed;           // Conexões em que o broker aceitou a sessão oferecida
+    uint32_t offered;           // Conexões que ofereceram a sessão guardada
+    uint32_t failures;          // Conexões que falharam
+    uint32_t full_p50_ms;       // Percentis e máximo dos handshakes completos
+    uint32_t full_max_ms;
+    uint32_t resumed_p50_ms;    // Percentis e máximo das retomadas
+    uint32_t resumed_max_ms;
+} mqtt_tls_stats_t;
+
+#if CONFIG_STATION_MQTT_TLS_RESUME
+
+// Cria o transporte para o cliente MQTT (campo network.transport). ca_pem é o
+// certificado da CA do broker em PEM, ou NULL para usar o pacote de CAs do IDF.
+// Retorna NULL se a URI não for mqtts://, deixando o cliente usar o transporte padrão.
+esp_transport_handle_t mqtt_tls_transport(const char *uri, const char *ca_pem);
+
+// Copia os contadores atuais
+void mqtt_tls_get_stats(mqtt_tls_stats_t *out);
+
+#else
+
+static inline esp_transport_handle_t mqtt_tls_transport(const char *uri, const char *ca_pem) {
+    return NULL;
+}
+
+#endif
+
+#endif // MQTT_TLS_H
@@ -0,0 +1,94 @@
+#include "power.h"
+
+#if CONFIG_STATION_PM
+
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+
+static const char *TAG = "POWER";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED; // Protege os contadores
+static int64_t s_start_us;
+static int64_t s_slept_us;
+static uint32_t s_sleeps;
+static power_stats_t s_last_report;     // Contadores no relatório anterior
+
+// Tarefa dos relatórios: escrever na UART e percorrer as travas de PM fica
+// fora da station_task, na menor prioridade
+static StaticTask_t s_task_buf;
+static StackType_t s_task_stack[3072];
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+// Chamado pela tarefa ociosa ao sair de cada light sleep, com as interrupções desligadas
+static esp_err_t IRAM_ATTR on_light_sleep_exit(int64_t sleep_time_us, void *arg) {
+    portENTER_CRITICAL_ISR(&s_lock);
+    s_slept_us += sleep_time_us;
+    s_sleeps++;
+    portEXIT_CRITICAL_ISR(&s_lock);
+    return ESP_OK;
+}
+#endif
+
+static void power_task(void *pvParameters) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_STATION_PM_REPORT_PERIOD_S * 1000));
+        power_report();
+    }
+}
+
+void power_init(void) {
+    esp_pm_config_t config = {
+        .max_freq_mhz = CONFIG_STATION_PM_MAX_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_STATION_PM_MIN_FREQ_MHZ,
+#if CONFIG_STATION_PM_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o gerenciamento de energia: %s", esp_err_to_name(err));
+        return;
+    }
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {.exit_cb = on_light_sleep_exit};
+    ESP_ERROR_CHECK(esp_pm_light_sleep_register_cbs(&cbs));
+#endif
+    s_start_us = esp_timer_get_time();
+    xTaskCreateStatic(power_task, "power_task", sizeof(s_task_stack), NULL, 1, s_task_stack, &s_task_buf);
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep automático %s", CONFIG_STATION_PM_MIN_FREQ_MHZ,
+             CONFIG_STATION_PM_MAX_FREQ_MHZ, config.light_sleep_enable ? "ligado" : "desligado");
+}
+
+void power_get_stats(power_stats_t *out) {
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_lock);
+    out->slept_us = s_slept_us;
+    out->sleeps = s_sleeps;
+    taskEXIT_CRITICAL(&s_lock);
+    out->elapsed_us = now - s_start_us;
+}
+
+void power_report(void) {
+    power_stats_t st;
+    power_get_stats(&st);
+    int64_t elapsed = st.elapsed_us - s_last_report.elapsed_us;
+    int64_t slept = st.slept_us - s_last_report.slept_us;
+    uint32_t sleeps = st.sleeps - s_last_report.sleeps;
+    s_last_report = st;
+    if (elapsed <= 0) return;
+
+    ESP_LOGI(TAG, "ciclo de trabalho: %.1f%% acordado | light sleeps:%lu (média %lu ms)",
+             100.0 * (elapsed - slept) / elapsed, (unsigned long)sleeps,
+             (unsigned long)(sleeps ? slept / sleeps / 1000 : 0));
+#if CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout); // Travas ativas e tempo em cada modo (CPU_MAX, APB_MAX, APB_MIN, LIGHT_SLEEP)
+#endif
+}
+
+#endif // CONFIG_STATION_PM
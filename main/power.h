@@ -0,0 +1,41 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// Gerenciamento de energia da estação: escalonamento dinâmico de frequência
+// (DFS) e light sleep automático entre as amostras, mantendo o Wi-Fi associado.
+// As seções sensíveis a tempo (leitura do DHT e redesenho do display) seguram
+// travas de PM próprias. Um gancho nos retornos do light sleep mede o ciclo de
+// trabalho; com CONFIG_PM_PROFILING o relatório inclui o tempo em cada
+// frequência.
+
+// Tempo acumulado desde power_init()
+typedef struct {
+    int64_t elapsed_us;     // Tempo total medido
+    int64_t slept_us;       // Tempo em light sleep
+    uint32_t sleeps;        // Quantidade de light sleeps
+} power_stats_t;
+
+#if CONFIG_STATION_PM
+
+// Configura o DFS e o light sleep automático e inicia a tarefa de baixa
+// prioridade que chama power_report() a cada CONFIG_STATION_PM_REPORT_PERIOD_S
+void power_init(void);
+
+// Copia os contadores atuais
+void power_get_stats(power_stats_t *out);
+
+// Registra no log o ciclo de trabalho desde o relatório anterior e, com
+// CONFIG_PM_PROFILING, o tempo em cada modo de frequência
+void power_report(void);
+
+#else
+
+static inline void power_init(void) {}
+
+#endif
+
+#endif // POWER_H
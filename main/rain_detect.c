@@ -0,0 +1,24 @@
+#include "rain_detect.h"
+
+unsigned rain_detect_step(rain_detect_state_t *st, const rain_detect_cfg_t *cfg,
+                          uint16_t chuva_raw, uint16_t ldr_raw) {
+    unsigned events = 0;
+
+    // Histerese da chuva (no ULP: M_BGE/M_BL sobre R0)
+    if (!st->raining) {
+        if (chuva_raw <= cfg->rain_on) {
+            st->raining = 1;
+            events |= RAIN_DETECT_EVENT_RAIN;
+        }
+    } else if (chuva_raw >= cfg->rain_off) {
+        st->raining = 0;
+    }
+
+    // Diferença absoluta em 16 bits (no ULP: SUB e desvio pelo overflow)
+    uint16_t diff = ldr_raw >= st->ldr_ref ? ldr_raw - st->ldr_ref : st->ldr_ref - ldr_raw;
+    if (diff >= cfg->light_delta) {
+        st->ldr_ref = ldr_raw;
+        events |= RAIN_DETECT_EVENT_LIGHT;
+    }
+    return events;
+}
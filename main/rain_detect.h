@@ -0,0 +1,36 @@
+#ifndef RAIN_DETECT_H
+#define RAIN_DETECT_H
+
+#include <stdint.h>
+
+// Detecção de início de chuva e de mudança brusca de luz a partir das leituras
+// brutas do ADC (12 bits). É o modelo em C puro do programa que o ULP executa
+// em ulp_sense.c, instrução a instrução: as duas implementações devem mudar
+// juntas. Compilado também na ferramenta do host tools/rain_detect_sim.c.
+//
+// Chuva: o sensor dá valores menores quanto mais molhado. Fora de chuva, uma
+// leitura <= rain_on marca o início e gera o evento; a chuva só termina com
+// uma leitura >= rain_off (histerese), sem evento.
+// Luz: uma diferença >= light_delta em relação à referência gera o evento e a
+// leitura passa a ser a nova referência. A referência começa em 0, então a
+// primeira leitura sempre gera o evento.
+
+#define RAIN_DETECT_EVENT_RAIN  0x1     // Início de chuva
+#define RAIN_DETECT_EVENT_LIGHT 0x2     // Mudança brusca de luminosidade
+
+typedef struct {
+    uint16_t rain_on;       // Leitura do sensor de chuva que marca o início (<=)
+    uint16_t rain_off;      // Leitura que marca o fim (>=), maior que rain_on
+    uint16_t light_delta;   // Variação do LDR que gera evento
+} rain_detect_cfg_t;
+
+typedef struct {
+    uint16_t raining;       // 1 enquanto chove
+    uint16_t ldr_ref;       // Leitura do LDR no último evento de luz
+} rain_detect_state_t;
+
+// Processa uma leitura e retorna os eventos gerados (RAIN_DETECT_EVENT_*)
+unsigned rain_detect_step(rain_detect_state_t *st, const rain_detect_cfg_t *cfg,
+                          uint16_t chuva_raw, uint16_t ldr_raw);
+
+#endif // RAIN_DETECT_H
@@ -0,0 +1,210 @@
+#include "rollup.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "history.h"
+
+#define ROLLUP_GUARD 2  // Folga em intervalos antes do ponto de escrita, como em history_api.h
+
+// Intervalo em formação: somas em float para calcular a média ao fechar
+typedef struct {
+    uint32_t start_s;
+    uint32_t count;
+    uint32_t n[STATION_FIELD_COUNT];
+    float sum[STATION_FIELD_COUNT];
+    int16_t min[STATION_FIELD_COUNT];
+    int16_t max[STATION_FIELD_COUNT];
+} rollup_acc_t;
+
+// Um nível agregado: anel de intervalos fechados mais o intervalo em formação
+typedef struct {
+    rollup_bucket_t *ring;
+    uint32_t len;
+    uint32_t period_s;
+    atomic_uint_least32_t count;    // Intervalos publicados no anel
+    rollup_acc_t acc;               // Só a station_task acessa
+} rollup_level_t;
+
+static rollup_bucket_t s_minutes[ROLLUP_MINUTES];
+static rollup_bucket_t s_hours[ROLLUP_HOURS];
+
+static rollup_level_t s_levels[ROLLUP_TIERS] = {
+    [ROLLUP_TIER_MINUTE] = {.ring = s_minutes, .len = ROLLUP_MINUTES, .period_s = 60},
+    [ROLLUP_TIER_HOUR] = {.ring = s_hours, .len = ROLLUP_HOURS, .period_s = 3600},
+};
+
+// 10^casas decimais do campo
+static float field_scale(int field) {
+    static const float scales[] = {1, 10, 100, 1000};
+    return scales[station_fields[field].decimals < 3 ? station_fields[field].decimals : 3];
+}
+
+static int16_t to_i16(float v) {
+    v = roundf(v);
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+// Uma amostra bruta é um intervalo de uma única amostra
+static void sample_to_bucket(const station_sample_t *s, rollup_bucket_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->start_s = (uint32_t)(s->timestamp_ms / 1000);
+    b->count = 1;
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        if (s->invalid & (1u << f)) continue; // Leitura com falha não entra no resumo
+        b->n[f] = 1;
+        b->mean[f] = b->min[f] = b->max[f] = to_i16(s->value[f] * field_scale(f));
+    }
+}
+
+static void acc_add(rollup_acc_t *a, const rollup_bucket_t *b) {
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        if (b->n[f] == 0) continue;
+        if (a->n[f] == 0 || b->min[f] < a->min[f]) a->min[f] = b->min[f];
+        if (a->n[f] == 0 || b->max[f] > a->max[f]) a->max[f] = b->max[f];
+        a->sum[f] += (float)b->mean[f] * b->n[f]; // Média ponderada pelo número de amostras
+        a->n[f] += b->n[f];
+    }
+    a->count += b->count;
+}
+
+static inline uint16_t to_u16(uint32_t v) {
+    return v > UINT16_MAX ? UINT16_MAX : v;
+}
+
+static void acc_close(const rollup_acc_t *a, rollup_bucket_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->start_s = a->start_s;
+    b->count = to_u16(a->count);
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        if (a->n[f] == 0) continue;
+        b->n[f] = to_u16(a->n[f]);
+        b->min[f] = a->min[f];
+        b->max[f] = a->max[f];
+        b->mean[f] = to_i16(a->sum[f] / a->n[f]);
+    }
+}
+
+// Acrescenta um intervalo do nível anterior; ao mudar de período, publica o
+// intervalo em formação e o repassa ao nível seguinte
+static void level_add(rollup_tier_t tier, const rollup_bucket_t *b) {
+    rollup_level_t *l = &s_levels[tier];
+    uint32_t start = b->start_s - b->start_s % l->period_s;
+
+    if (l->acc.count > 0 && start != l->acc.start_s) {
+        rollup_bucket_t closed;
+        acc_close(&l->acc, &closed);
+        uint32_t c = atomic_load_explicit(&l->count, memory_order_relaxed);
+        l->ring[c % l->len] = closed;
+        // Publica o intervalo somente depois de gravado por completo
+        atomic_store_explicit(&l->count, c + 1, memory_order_release);
+        if (tier + 1 < ROLLUP_TIERS) {
+            level_add(tier + 1, &closed);
+        }
+        l->acc.count = 0;
+    }
+    if (l->acc.count == 0) {
+        memset(&l->acc, 0, sizeof(l->acc));
+        l->acc.start_s = start;
+    }
+    acc_add(&l->acc, b);
+}
+
+void rollup_push(const station_sample_t *sample) {
+    rollup_bucket_t b;
+    sample_to_bucket(sample, &b);
+    level_add(ROLLUP_TIER_MINUTE, &b);
+}
+
+uint32_t rollup_period_s(rollup_tier_t tier) {
+    return s_levels[tier].period_s;
+}
+
+const char *rollup_tier_name(rollup_tier_t tier) {
+    static const char *const names[ROLLUP_TIERS] = {"raw", "min", "hour"};
+    return names[tier];
+}
+
+float rollup_value(station_field_t field, int16_t v) {
+    return v / field_scale(field);
+}
+
+// Seção de leitura (qualquer tarefa)
+
+static uint32_t level_count(rollup_tier_t tier) {
+    if (tier == ROLLUP_TIER_RAW) return history_count();
+    return atomic_load_explicit(&s_levels[tier].count, memory_order_acquire);
+}
+
+static uint32_t level_oldest(rollup_tier_t tier) {
+    if (tier == ROLLUP_TIER_RAW) return history_oldest(ROLLUP_GUARD);
+    uint32_t c = level_count(tier);
+    uint32_t keep = s_levels[tier].len - ROLLUP_GUARD;
+    return c > keep ? c - keep : 0;
+}
+
+static bool level_get(rollup_tier_t tier, uint32_t index, rollup_bucket_t *out) {
+    if (tier == ROLLUP_TIER_RAW) {
+        station_sample_t s;
+        if (!history_get(index, &s)) return false;
+        sample_to_bucket(&s, out);
+        return true;
+    }
+    const rollup_level_t *l = &s_levels[tier];
+    if (index >= level_count(tier)) return false;
+    *out = l->ring[index % l->len];
+    // Mesma margem estrita de history_valid()
+    return index + l->len > level_count(tier);
+}
+
+// Busca binária do primeiro índice em [lo, hi) com start_s + offset >= t_s.
+// Intervalos sobrescritos durante a busca contam como antigos demais.
+static uint32_t level_search(rollup_tier_t tier, uint32_t lo, uint32_t hi, uint64_t t_s, uint32_t offset) {
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        rollup_bucket_t b;
+        if (!level_get(tier, mid, &b) || (uint64_t)b.start_s + offset < t_s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Primeiro intervalo que termina em from_s ou depois
+static uint32_t level_first(rollup_tier_t tier, uint32_t from_s, uint32_t end) {
+    uint32_t period = rollup_period_s(tier);
+    return level_search(tier, level_oldest(tier), end, from_s, period ? period - 1 : 0);
+}
+
+rollup_tier_t rollup_pick(uint32_t from_s, uint32_t to_s, uint32_t max_points) {
+    for (rollup_tier_t tier = ROLLUP_TIER_RAW; tier < ROLLUP_TIER_HOUR; tier++) {
+        uint32_t oldest = level_oldest(tier);
+        rollup_bucket_t b;
+        // Cobre o intervalo se guarda tudo desde o boot ou se o intervalo mais
+        // antigo ainda no anel começa até from_s
+        bool covers = oldest == 0 || (level_get(tier, oldest, &b) && b.start_s <= from_s);
+        if (!covers) continue;
+        if (max_points == 0) return tier;
+        uint32_t end = level_count(tier);
+        uint32_t first = level_first(tier, from_s, end);
+        uint32_t last = level_search(tier, first, end, (uint64_t)to_s + 1, 0);
+        if (last - first <= max_points) return tier;
+    }
+    return ROLLUP_TIER_HOUR;
+}
+
+int rollup_query(rollup_tier_t tier, uint32_t from_s, uint32_t to_s, rollup_visit_fn visit, void *ctx) {
+    uint32_t end = level_count(tier);
+    for (uint32_t i = level_first(tier, from_s, end); i < end; i++) {
+        rollup_bucket_t b;
+        if (!level_get(tier, i, &b)) return -1; // Sobrescrito durante a consulta
+        if (b.start_s > to_s) break;
+        if (visit(ctx, &b) != 0) return -1;
+    }
+    return 0;
+}
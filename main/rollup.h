@@ -0,0 +1,71 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "station.h"
+
+// Histórico em várias resoluções: as amostras brutas (anel de history.h) são
+// resumidas em intervalos de um minuto e estes em intervalos de uma hora, cada
+// nível num anel de tamanho fixo. A memória não depende do tempo ligado: o
+// nível de minutos cobre algumas horas e o de horas, alguns dias. Mesmo modelo
+// de concorrência do history.h (um escritor, leitores sem trava). Código C
+// puro, usado também no host.
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#define ROLLUP_MINUTES CONFIG_STATION_ROLLUP_MINUTES
+#define ROLLUP_HOURS   CONFIG_STATION_ROLLUP_HOURS
+
+typedef enum {
+    ROLLUP_TIER_RAW,        // Amostras do history.h, no período da station_task
+    ROLLUP_TIER_MINUTE,
+    ROLLUP_TIER_HOUR,
+    ROLLUP_TIERS,
+} rollup_tier_t;
+
+// Resumo de um intervalo, com um valor por campo de station_fields.h em
+// unidades de 10^-casas decimais (décimos de °C, por exemplo). Uma amostra
+// bruta vira um intervalo com count = 1. Intervalos sem nenhuma amostra
+// (estação desligada) não são gravados.
+typedef struct {
+    uint32_t start_s;                       // Início do intervalo (s desde o boot)
+    uint16_t count;                         // Amostras no intervalo
+    uint16_t n[STATION_FIELD_COUNT];        // Das quais com leitura válida do campo
+    int16_t min[STATION_FIELD_COUNT];
+    int16_t max[STATION_FIELD_COUNT];
+    int16_t mean[STATION_FIELD_COUNT];
+} rollup_bucket_t;
+
+// Recebe cada amostra logo após history_push() (apenas a station_task chama).
+// Um intervalo só fica visível aos leitores depois de fechado, quando chega a
+// primeira amostra do intervalo seguinte.
+void rollup_push(const station_sample_t *sample);
+
+// Duração de um intervalo do nível (0 para as amostras brutas)
+uint32_t rollup_period_s(rollup_tier_t tier);
+
+// Nome curto do nível ("raw", "min", "hour")
+const char *rollup_tier_name(rollup_tier_t tier);
+
+// Converte um valor de rollup_bucket_t para a unidade do campo
+float rollup_value(station_field_t field, int16_t v);
+
+// Escolhe o nível para o intervalo [from_s, to_s]: o mais fino cuja retenção
+// ainda alcança from_s e que entrega no máximo max_points intervalos (0 = sem
+// limite). Só passa para um nível mais grosso quando o anterior não cobre o
+// intervalo pedido; se nenhum cobre, usa o de horas.
+rollup_tier_t rollup_pick(uint32_t from_s, uint32_t to_s, uint32_t max_points);
+
+// Chamada para cada intervalo encontrado; retorna 0 para continuar
+typedef int (*rollup_visit_fn)(void *ctx, const rollup_bucket_t *b);
+
+// Entrega em ordem cronológica os intervalos do nível que se sobrepõem a
+// [from_s, to_s]. Retorna 0 em sucesso e -1 se visit falhou ou os dados foram
+// sobrescritos durante a consulta.
+int rollup_query(rollup_tier_t tier, uint32_t from_s, uint32_t to_s, rollup_visit_fn visit, void *ctx);
+
+#endif // ROLLUP_H
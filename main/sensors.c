@@ -0,0 +1,178 @@
+#include "sensors.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "dht.h"
+#include "dlog.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "SENSORES";
+
+static const sensor_desc_t *s_table;
+static size_t s_count;
+static adc_oneshot_unit_handle_t s_adc;
+static int64_t s_next_ms[SENSORS_MAX];         // Próxima leitura de cada linha
+static int s_raw[SENSORS_MAX];                 // Última leitura bruta de cada linha (-1: falhou)
+static int8_t s_row[STATION_FIELD_COUNT];      // Linha que alimenta cada campo (-1: nenhuma)
+static float s_value[STATION_FIELD_COUNT];     // Último valor de cada campo
+static uint32_t s_invalid;                     // Campos sem leitura válida
+
+float sensor_conv_raw(int raw) {
+    return raw;
+}
+
+float sensor_conv_tenths(int raw) {
+    return raw / 10.0f;
+}
+
+float sensor_conv_percent_inv(int raw) {
+    return (int)(((4095.0 - raw) / 4095.0) * 100);
+}
+
+// Registra a leitura de uma linha (ok = false em caso de falha)
+static void store(size_t row, bool ok, int raw) {
+    const sensor_desc_t *d = &s_table[row];
+    uint32_t bit = 1u << d->field;
+    s_raw[row] = ok ? raw : -1;
+    if (!ok) {
+        s_value[d->field] = -1; // Valor de erro, como no JSON publicado
+        s_invalid |= bit;
+        return;
+    }
+    s_value[d->field] = d->convert(raw);
+    s_invalid &= ~bit;
+    DLOG(DLOG_SENSOR_LEITURA, (unsigned)row, s_value[d->field], raw);
+}
+
+esp_err_t sensors_init(const sensor_desc_t *table, size_t count, adc_oneshot_unit_handle_t adc) {
+    if (count > SENSORS_MAX) {
+        ESP_LOGE(TAG, "Tabela com %u linhas, limite %d", (unsigned)count, SENSORS_MAX);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(s_row, -1, sizeof(s_row));
+
+    // Canais com atenuação para ler até ~3.3V, na resolução padrão (12 bits)
+    adc_oneshot_chan_cfg_t config = {
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+        .atten = ADC_ATTEN_DB_12,
+    };
+    int dht_pins[DHT_MULTI_MAX];
+    size_t ndht = 0;
+    for (size_t i = 0; i < count; i++) {
+        const sensor_desc_t *d = &table[i];
+        if (d->field >= STATION_FIELD_COUNT || s_row[d->field] >= 0 || !d->convert) {
+            ESP_LOGE(TAG, "Linha %u: campo inválido, repetido ou sem conversão", (unsigned)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_row[d->field] = i;
+        s_raw[i] = -1;
+        s_next_ms[i] = 0;
+
+        if (d->type == SENSOR_ADC) {
+            // Também no modo ULP: o programa do ULP usa os canais já configurados
+            esp_err_t err = adc_oneshot_config_channel(adc, d->io, &config);
+            if (err != ESP_OK) return err;
+            continue;
+        }
+        size_t k = 0;
+        while (k < ndht && dht_pins[k] != d->io) k++;
+        if (k == ndht) {
+            if (ndht == DHT_MULTI_MAX) {
+                ESP_LOGE(TAG, "Mais de %d sensores DHT", DHT_MULTI_MAX);
+                return ESP_ERR_INVALID_SIZE;
+            }
+            dht_pins[ndht++] = d->io;
+        }
+    }
+
+    // Até a primeira leitura, e para sempre nos campos sem sensor, o valor é o de erro
+    s_invalid = 0;
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        s_value[f] = -1;
+        s_invalid |= 1u << f;
+        if (s_row[f] < 0) {
+            ESP_LOGW(TAG, "Campo \"%s\" sem sensor na tabela", station_fields[f].key);
+        }
+    }
+    s_table = table;
+    s_count = count;
+    s_adc = adc;
+    ESP_LOGI(TAG, "%u sensores, %u DHT lidos em paralelo", (unsigned)count, (unsigned)ndht);
+    return ESP_OK;
+}
+
+void sensors_read(station_sample_t *sample, int64_t now_ms) {
+    dht_multi_t dht[DHT_MULTI_MAX];
+    size_t ndht = 0;
+    uint32_t due_dht = 0; // Linhas de DHT vencidas neste ciclo
+
+    for (size_t i = 0; i < s_count; i++) {
+        const sensor_desc_t *d = &s_table[i];
+        if (now_ms < s_next_ms[i]) continue;
+        s_next_ms[i] = now_ms + d->period_ms;
+
+        if (d->type == SENSOR_ADC) {
+#if !CONFIG_STATION_ULP_SENSE // No modo ULP quem lê o ADC1 é o ULP
+            int raw = 0;
+            bool ok = adc_oneshot_read(s_adc, d->io, &raw) == ESP_OK;
+            if (!ok) {
+                DLOG(DLOG_SENSOR_ADC_FALHA, d->io);
+            }
+            store(i, ok, raw);
+#endif
+            continue;
+        }
+
+        // Uma entrada por pino, compartilhada pelas grandezas do mesmo DHT
+        due_dht |= 1u << i;
+        size_t k = 0;
+        while (k < ndht && dht[k].pin != d->io) k++;
+        if (k == ndht) {
+            dht[ndht++] = (dht_multi_t){
+                .sensor_type = d->type == SENSOR_DHT11 ? DHT_TYPE_DHT11 : DHT_TYPE_AM2301,
+                .pin = d->io,
+            };
+        }
+    }
+
+    // Todos os DHT vencidos de uma vez
+    if (ndht > 0) {
+        dht_read_multi(dht, ndht);
+        for (size_t k = 0; k < ndht; k++) {
+            if (dht[k].result != ESP_OK) {
+                DLOG(DLOG_SENSOR_DHT_FALHA, dht[k].pin);
+            }
+        }
+    }
+    for (size_t i = 0; due_dht; i++) {
+        if (!(due_dht & (1u << i))) continue;
+        due_dht &= ~(1u << i);
+        const sensor_desc_t *d = &s_table[i];
+        size_t k = 0;
+        while (dht[k].pin != d->io) k++;
+        int raw = d->value == SENSOR_VALUE_TEMPERATURA ? dht[k].temperature : dht[k].humidity;
+        store(i, dht[k].result == ESP_OK, raw);
+    }
+
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        sample->value[f] = s_value[f];
+    }
+    sample->invalid = s_invalid;
+}
+
+void sensors_store_raw(station_field_t field, int raw) {
+    if (s_row[field] >= 0) {
+        store(s_row[field], true, raw);
+    }
+}
+
+int sensors_adc_channel(station_field_t field) {
+    int row = s_row[field];
+    return row >= 0 && s_table[row].type == SENSOR_ADC ? s_table[row].io : -1;
+}
+
+int sensors_raw(station_field_t field) {
+    return s_row[field] >= 0 ? s_raw[s_row[field]] : -1;
+}
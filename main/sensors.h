@@ -0,0 +1,68 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_adc/adc_oneshot.h"
+#include "esp_err.h"
+#include "station.h"
+
+// Registro de sensores: uma tabela de descritores (tipo, pino ou canal,
+// período, conversão e campo de saída) no lugar das leituras fixas da
+// station_task. A cada ciclo os sensores vencidos são lidos juntos: os canais
+// do ADC um após o outro (microssegundos cada) e todos os DHT numa única
+// leitura simultânea (dht_read_multi), que leva o mesmo tempo para um ou oito
+// sensores. Um DHT fornece dois campos: uma linha para cada grandeza, com o
+// mesmo pino, atendidas pela mesma leitura.
+
+#define SENSORS_MAX 32  // Linhas da tabela
+
+typedef enum {
+    SENSOR_ADC,         // Canal do ADC1, leitura de 12 bits
+    SENSOR_DHT11,
+    SENSOR_DHT22,       // Também AM2301 e AM2302
+} sensor_type_t;
+
+// Grandeza entregue à conversão
+typedef enum {
+    SENSOR_VALUE_RAW,           // ADC: leitura bruta (0 a 4095)
+    SENSOR_VALUE_TEMPERATURA,   // DHT: décimos de °C
+    SENSOR_VALUE_UMIDADE,       // DHT: décimos de %
+} sensor_value_t;
+
+typedef struct {
+    sensor_type_t type;
+    int io;                     // GPIO (DHT) ou canal do ADC1 (ADC)
+    sensor_value_t value;
+    uint32_t period_ms;         // Intervalo mínimo entre leituras (0 = a cada ciclo)
+    float (*convert)(int raw);  // Da leitura bruta para a unidade do campo
+    station_field_t field;      // Campo da amostra que recebe o valor
+} sensor_desc_t;
+
+// Conversões prontas
+float sensor_conv_raw(int raw);             // Sem conversão (ex.: KY-028)
+float sensor_conv_tenths(int raw);          // Décimos para unidades (DHT)
+float sensor_conv_percent_inv(int raw);     // % invertida: leitura maior = menos luz/chuva
+
+// Valida a tabela e configura os canais do ADC1. A tabela deve continuar
+// existindo depois da chamada. Cada campo é alimentado por uma única linha.
+esp_err_t sensors_init(const sensor_desc_t *table, size_t count, adc_oneshot_unit_handle_t adc);
+
+// Lê os sensores vencidos e preenche todos os campos da amostra; os campos
+// cujo sensor não venceu repetem a última leitura. Apenas a station_task chama.
+// No modo ULP os canais do ADC1 não são lidos aqui (ver sensors_store_raw()).
+void sensors_read(station_sample_t *sample, int64_t now_ms);
+
+// Entrega ao registro a leitura bruta de um campo feita fora dele (pelo ULP),
+// convertida como na tabela na próxima sensors_read()
+void sensors_store_raw(station_field_t field, int raw);
+
+// Canal do ADC1 da linha que alimenta o campo, ou -1
+int sensors_adc_channel(station_field_t field);
+
+// Última leitura bruta da linha que alimenta o campo; -1 se a leitura falhou
+// ou não há sensor (usada com os canais do ADC)
+int sensors_raw(station_field_t field);
+
+#endif // SENSORS_H
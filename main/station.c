@@ -0,0 +1,25 @@
+#include "station.h"
+
+#include <stdio.h>
+
+const station_field_info_t station_fields[STATION_FIELD_COUNT] = {
+#define STATION_FIELD(id, key, label, unit, decimals) [STATION_FIELD_##id] = {key, label, unit, decimals},
+#include "station_fields.h"
+#undef STATION_FIELD
+};
+
+int station_format_json(char *buf, size_t len, const station_sample_t *s) {
+    int used = 0;
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        used += snprintf(buf + used, (size_t)used < len ? len - used : 0, "%c\"%s\":%.*f", f ? ',' : '{',
+                         station_fields[f].key, station_fields[f].decimals, s->value[f]);
+    }
+    used += snprintf(buf + used, (size_t)used < len ? len - used : 0, "%s\"seq\":%lu,\"ts\":%lld}",
+                     STATION_FIELD_COUNT ? "," : "{", (unsigned long)s->seq, (long long)s->timestamp_ms);
+    return used;
+}
+
+int station_format_value(char *buf, size_t len, const station_sample_t *s, station_field_t field) {
+    const station_field_info_t *info = &station_fields[field];
+    return snprintf(buf, len, "%.*f%s%s", info->decimals, s->value[field], info->unit[0] ? " " : "", info->unit);
+}
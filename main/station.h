@@ -0,0 +1,49 @@
+#ifndef STATION_H
+#define STATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tipos compartilhados entre a tarefa de amostragem e os módulos da estação.
+// Este arquivo não depende do ESP-IDF para poder ser usado pelas ferramentas do host.
+
+// Campos da amostra, gerados a partir de station_fields.h
+typedef enum {
+#define STATION_FIELD(id, key, label, unit, decimals) STATION_FIELD_##id,
+#include "station_fields.h"
+#undef STATION_FIELD
+    STATION_FIELD_COUNT
+} station_field_t;
+
+_Static_assert(STATION_FIELD_COUNT <= 32, "station_sample_t.invalid comporta até 32 campos");
+
+// Descrição de um campo para o JSON e o display
+typedef struct {
+    const char *key;        // Chave no JSON
+    const char *label;      // Rótulo no display
+    const char *unit;       // Unidade no display ("" se não houver)
+    uint8_t decimals;       // Casas decimais (0 = inteiro)
+} station_field_info_t;
+
+extern const station_field_info_t station_fields[STATION_FIELD_COUNT];
+
+// Uma leitura completa dos sensores, produzida a cada ciclo da station_task
+typedef struct {
+    int64_t timestamp_ms;  // Instante da captura (ms desde o boot)
+    uint32_t seq;          // Número de sequência da amostra (reinicia a cada boot)
+    uint32_t invalid;      // Bit f ligado: o sensor do campo f falhou (o valor fica -1)
+    float value[STATION_FIELD_COUNT]; // Valores na unidade de cada campo
+} station_sample_t;
+
+// Tamanho máximo do JSON de uma amostra
+#define STATION_JSON_MAX (64 + 40 * STATION_FIELD_COUNT)
+
+// Formata a amostra no JSON publicado no tópico de dados. Os campos seq e ts
+// (timestamp) permitem medir perdas, reordenação e latência no assinante.
+// Retorna o tamanho como snprintf.
+int station_format_json(char *buf, size_t len, const station_sample_t *s);
+
+// Formata o valor de um campo com as casas decimais e a unidade do display
+int station_format_value(char *buf, size_t len, const station_sample_t *s, station_field_t field);
+
+#endif // STATION_H
@@ -0,0 +1,13 @@
+// Tabela dos campos de uma amostra (X-macro, incluída sem guarda).
+// STATION_FIELD(ID, chave JSON, rótulo no display, unidade, casas decimais)
+//   A ordem define a ordem no JSON, no display e nos blocos do backfill.
+//   Campos com 0 casas são inteiros (codificados por delta no tsblock); os
+//   demais, ponto flutuante. Cada campo é preenchido por uma linha da tabela de
+//   sensores em main.c. Ferramentas do host que decodificam blocos do backfill
+//   devem ser compiladas com a mesma tabela do firmware.
+
+STATION_FIELD(TEMPERATURA, "temperatura", "Temperatura", "C", 1)
+STATION_FIELD(UMIDADE, "umidade", "Umidade", "%", 1)
+STATION_FIELD(CHUVA, "chuva", "Chuva", "%", 0)
+STATION_FIELD(KY028, "ky028", "KY-028", "", 0)
+STATION_FIELD(LUMINOSIDADE, "luminosidade", "Luminosidade", "%", 0)
@@ -0,0 +1,277 @@
+#include "tsblock.h"
+
+#include <math.h>
+#include <string.h>
+
+// Seção de escrita e leitura de bits (MSB primeiro, após o cabeçalho)
+
+static void put_bits(tsblock_encoder_t *e, uint64_t value, unsigned nbits) {
+    size_t cap = (e->size - TSBLOCK_HEADER_SIZE) * 8;
+    while (nbits--) {
+        if (e->bitpos >= cap) {
+            e->overflow = true;
+            return;
+        }
+        uint8_t *byte = &e->buf[TSBLOCK_HEADER_SIZE + e->bitpos / 8];
+        uint8_t mask = 0x80 >> (e->bitpos % 8);
+        // Escreve o bit explicitamente para que um rollback possa ser sobrescrito
+        if ((value >> nbits) & 1) {
+            *byte |= mask;
+        } else {
+            *byte &= ~mask;
+        }
+        e->bitpos++;
+    }
+}
+
+static bool get_bits(tsblock_decoder_t *d, unsigned nbits, uint64_t *out) {
+    size_t cap = (d->len - TSBLOCK_HEADER_SIZE) * 8;
+    if (d->bitpos + nbits > cap) return false;
+    uint64_t v = 0;
+    while (nbits--) {
+        uint8_t byte = d->buf[TSBLOCK_HEADER_SIZE + d->bitpos / 8];
+        v = (v << 1) | ((byte >> (7 - d->bitpos % 8)) & 1);
+        d->bitpos++;
+    }
+    *out = v;
+    return true;
+}
+
+// Conta quantos bits '1' iniciam o próximo prefixo (até max)
+static bool get_prefix(tsblock_decoder_t *d, unsigned max, unsigned *ones) {
+    uint64_t bit;
+    for (*ones = 0; *ones < max; (*ones)++) {
+        if (!get_bits(d, 1, &bit)) return false;
+        if (!bit) break;
+    }
+    return true;
+}
+
+// Seção de codificação por campo
+
+// Timestamps: delta-of-delta em zigzag
+//   '0' = igual | '10' + 7 bits | '110' + 12 bits | '1110' + 20 bits | '1111' + 64 bits
+static void put_timestamp(tsblock_encoder_t *e, int64_t ts) {
+    int64_t delta = ts - e->st.timestamp;
+    int64_t dod = delta - e->st.delta;
+    uint64_t zz = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+    e->st.timestamp = ts;
+    e->st.delta = delta;
+
+    if (zz == 0) {
+        put_bits(e, 0x0, 1);
+    } else if (zz < (1u << 7)) {
+        put_bits(e, 0x2, 2);
+        put_bits(e, zz, 7);
+    } else if (zz < (1u << 12)) {
+        put_bits(e, 0x6, 3);
+        put_bits(e, zz, 12);
+    } else if (zz < (1u << 20)) {
+        put_bits(e, 0xE, 4);
+        put_bits(e, zz, 20);
+    } else {
+        put_bits(e, 0xF, 4);
+        put_bits(e, zz, 64);
+    }
+}
+
+static bool get_timestamp(tsblock_decoder_t *d, int64_t *ts) {
+    static const unsigned widths[] = {0, 7, 12, 20, 64};
+    unsigned ones;
+    uint64_t zz = 0;
+    if (!get_prefix(d, 4, &ones)) return false;
+    if (widths[ones] && !get_bits(d, widths[ones], &zz)) return false;
+    int64_t dod = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+    d->st.delta += dod;
+    d->st.timestamp += d->st.delta;
+    *ts = d->st.timestamp;
+    return true;
+}
+
+// Floats: XOR com o valor anterior
+//   '0' = igual | '10' + bits na janela anterior | '11' + 5 bits zeros à esquerda
+//   + 5 bits (tamanho - 1) + bits significativos
+static void put_float(tsblock_encoder_t *e, int i, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint32_t x = bits ^ e->st.fbits[i];
+    e->st.fbits[i] = bits;
+
+    if (x == 0) {
+        put_bits(e, 0x0, 1);
+        return;
+    }
+    unsigned lead = __builtin_clz(x);
+    unsigned trail = __builtin_ctz(x);
+    unsigned plead = e->st.lead[i], ptrail = e->st.trail[i];
+    unsigned reuse_len = 32 - plead - ptrail;
+    unsigned new_len = 32 - lead - trail;
+
+    // Reaproveita a janela anterior só quando ela contém o XOR e não custa mais
+    if (lead >= plead && trail >= ptrail && reuse_len <= new_len + 10) {
+        put_bits(e, 0x2, 2);
+        put_bits(e, x >> ptrail, reuse_len);
+    } else {
+        put_bits(e, 0x3, 2);
+        put_bits(e, lead, 5);
+        put_bits(e, new_len - 1, 5);
+        put_bits(e, x >> trail, new_len);
+        e->st.lead[i] = lead;
+        e->st.trail[i] = trail;
+    }
+}
+
+static bool get_float(tsblock_decoder_t *d, int i, float *v) {
+    uint64_t bit, lead, len, meaningful;
+    if (!get_bits(d, 1, &bit)) return false;
+    if (bit) {
+        if (!get_bits(d, 1, &bit)) return false;
+        if (bit) {
+            if (!get_bits(d, 5, &lead) || !get_bits(d, 5, &len)) return false;
+            len += 1;
+            if (lead + len > 32) return false;
+            d->st.lead[i] = lead;
+            d->st.trail[i] = 32 - lead - len;
+        }
+        len = 32 - d->st.lead[i] - d->st.trail[i];
+        if (!get_bits(d, len, &meaningful)) return false;
+        d->st.fbits[i] ^= (uint32_t)(meaningful << d->st.trail[i]);
+    }
+    memcpy(v, &d->st.fbits[i], sizeof(*v));
+    return true;
+}
+
+// Inteiros: delta em zigzag
+//   '0' = igual | '10' + 6 bits | '110' + 12 bits | '111' + 32 bits
+static void put_delta(tsblock_encoder_t *e, uint32_t delta) {
+    uint32_t zz = (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+
+    if (zz == 0) {
+        put_bits(e, 0x0, 1);
+    } else if (zz < (1u << 6)) {
+        put_bits(e, 0x2, 2);
+        put_bits(e, zz, 6);
+    } else if (zz < (1u << 12)) {
+        put_bits(e, 0x6, 3);
+        put_bits(e, zz, 12);
+    } else {
+        put_bits(e, 0x7, 3);
+        put_bits(e, zz, 32);
+    }
+}
+
+static bool get_delta(tsblock_decoder_t *d, uint32_t *delta) {
+    static const unsigned widths[] = {0, 6, 12, 32};
+    unsigned ones;
+    uint64_t zz = 0;
+    if (!get_prefix(d, 3, &ones)) return false;
+    if (widths[ones] && !get_bits(d, widths[ones], &zz)) return false;
+    *delta = (uint32_t)(zz >> 1) ^ -(uint32_t)(zz & 1);
+    return true;
+}
+
+static void put_int(tsblock_encoder_t *e, int i, int32_t v) {
+    put_delta(e, (uint32_t)v - (uint32_t)e->st.ivals[i]);
+    e->st.ivals[i] = v;
+}
+
+static bool get_int(tsblock_decoder_t *d, int i, int *v) {
+    uint32_t delta;
+    if (!get_delta(d, &delta)) return false;
+    d->st.ivals[i] = (int32_t)((uint32_t)d->st.ivals[i] + delta);
+    *v = d->st.ivals[i];
+    return true;
+}
+
+// Sequência: lacuna em relação à esperada (anterior + 1), normalmente '0'
+static void put_seq(tsblock_encoder_t *e, uint32_t seq) {
+    put_delta(e, seq - e->st.seq - 1);
+    e->st.seq = seq;
+}
+
+static bool get_seq(tsblock_decoder_t *d, uint32_t *seq) {
+    uint32_t gap;
+    if (!get_delta(d, &gap)) return false;
+    d->st.seq += gap + 1;
+    *seq = d->st.seq;
+    return true;
+}
+
+// Seção da API pública
+
+void tsblock_encoder_init(tsblock_encoder_t *e, uint8_t *buf, size_t size) {
+    memset(e, 0, sizeof(*e));
+    e->buf = buf;
+    e->size = size;
+}
+
+bool tsblock_append(tsblock_encoder_t *e, const station_sample_t *s) {
+    if (e->count == UINT16_MAX) return false;
+
+    // Guarda o estado para desfazer a amostra caso ela não caiba no bloco
+    size_t bitpos = e->bitpos;
+    tsblock_state_t st = e->st;
+
+    put_timestamp(e, s->timestamp_ms);
+    put_seq(e, s->seq);
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        if (station_fields[f].decimals) {
+            put_float(e, f, s->value[f]);
+        } else {
+            put_int(e, f, (int32_t)lroundf(s->value[f]));
+        }
+    }
+
+    if (e->overflow) {
+        e->bitpos = bitpos;
+        e->st = st;
+        e->overflow = false;
+        return false;
+    }
+    e->count++;
+    return true;
+}
+
+size_t tsblock_finish(tsblock_encoder_t *e) {
+    size_t len = TSBLOCK_HEADER_SIZE + (e->bitpos + 7) / 8;
+    e->buf[0] = TSBLOCK_MAGIC;
+    e->buf[1] = TSBLOCK_VERSION;
+    e->buf[2] = e->count & 0xFF;
+    e->buf[3] = e->count >> 8;
+    e->buf[4] = len & 0xFF;
+    e->buf[5] = (len >> 8) & 0xFF;
+    return len;
+}
+
+bool tsblock_decoder_init(tsblock_decoder_t *d, const uint8_t *buf, size_t len) {
+    memset(d, 0, sizeof(*d));
+    if (len < TSBLOCK_HEADER_SIZE || buf[0] != TSBLOCK_MAGIC || buf[1] != TSBLOCK_VERSION) {
+        return false;
+    }
+    size_t block_len = buf[4] | (buf[5] << 8);
+    if (block_len < TSBLOCK_HEADER_SIZE || block_len > len) return false;
+    d->buf = buf;
+    d->len = block_len;
+    d->remaining = buf[2] | (buf[3] << 8);
+    return true;
+}
+
+bool tsblock_next(tsblock_decoder_t *d, station_sample_t *s) {
+    if (d->remaining == 0) return false;
+    bool ok = get_timestamp(d, &s->timestamp_ms) && get_seq(d, &s->seq);
+    for (int f = 0; ok && f < STATION_FIELD_COUNT; f++) {
+        int v;
+        if (station_fields[f].decimals) {
+            ok = get_float(d, f, &s->value[f]);
+        } else if ((ok = get_int(d, f, &v))) {
+            s->value[f] = v;
+        }
+    }
+    if (!ok) {
+        d->remaining = 0;
+        return false;
+    }
+    s->invalid = 0; // Não é transmitido: falhas chegam como -1, como no JSON
+    d->remaining--;
+    return true;
+}
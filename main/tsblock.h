@@ -0,0 +1,71 @@
+#ifndef TSBLOCK_H
+#define TSBLOCK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "station.h"
+
+// Compressor de séries temporais em blocos de tamanho fixo, no estilo Gorilla:
+//  - timestamps: delta-of-delta com prefixos de tamanho variável
+//  - sequência: lacuna em relação à amostra anterior (1 bit sem perdas)
+//  - campos com casas decimais (float): XOR com o valor anterior
+//  - campos inteiros: delta em zigzag com prefixos de tamanho
+// Os campos seguem a ordem de station_fields.h.
+// Código C puro, compilado tanto no firmware quanto na ferramenta do host
+// (tools/backfill_decode.c).
+//
+// Formato do bloco (little-endian):
+//   [0] TSBLOCK_MAGIC  [1] TSBLOCK_VERSION  [2..3] amostras  [4..5] bytes totais
+//   [6..] fluxo de bits (MSB primeiro)
+
+#define TSBLOCK_MAGIC       0x47    // 'G'
+#define TSBLOCK_VERSION     2
+#define TSBLOCK_HEADER_SIZE 6
+
+// Estado de predição compartilhado por codificador e decodificador
+typedef struct {
+    int64_t timestamp;
+    int64_t delta;
+    uint32_t seq;
+    // Por campo; cada campo usa só o estado do seu tipo
+    uint32_t fbits[STATION_FIELD_COUNT];    // Bits do último float
+    uint8_t lead[STATION_FIELD_COUNT];      // Janela XOR anterior: zeros à esquerda
+    uint8_t trail[STATION_FIELD_COUNT];     // Janela XOR anterior: zeros à direita
+    int32_t ivals[STATION_FIELD_COUNT];     // Último inteiro
+} tsblock_state_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;            // Capacidade do bloco em bytes
+    size_t bitpos;          // Próximo bit a escrever (contado a partir do cabeçalho)
+    uint16_t count;         // Amostras no bloco
+    bool overflow;
+    tsblock_state_t st;
+} tsblock_encoder_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;             // Bytes válidos do bloco
+    size_t bitpos;
+    uint16_t remaining;     // Amostras ainda não decodificadas
+    tsblock_state_t st;
+} tsblock_decoder_t;
+
+// Prepara um bloco vazio sobre buf (size >= TSBLOCK_HEADER_SIZE + 1)
+void tsblock_encoder_init(tsblock_encoder_t *e, uint8_t *buf, size_t size);
+
+// Acrescenta uma amostra. Retorna false (sem alterar o bloco) se ela não couber.
+bool tsblock_append(tsblock_encoder_t *e, const station_sample_t *s);
+
+// Grava o cabeçalho e retorna o tamanho do bloco em bytes
+size_t tsblock_finish(tsblock_encoder_t *e);
+
+// Valida o cabeçalho do bloco em buf. Retorna false se o bloco for inválido.
+bool tsblock_decoder_init(tsblock_decoder_t *d, const uint8_t *buf, size_t len);
+
+// Decodifica a próxima amostra. Retorna false ao fim do bloco ou se ele estiver truncado.
+bool tsblock_next(tsblock_decoder_t *d, station_sample_t *s);
+
+#endif // TSBLOCK_H
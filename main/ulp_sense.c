@@ -0,0 +1,223 @@
+#include "ulp_sense.h"
+
+#if CONFIG_STATION_ULP_SENSE
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "soc/soc.h"
+#include "ulp.h"
+#include "rain_detect.h"
+
+// Layout da memória RTC lenta (palavras de 32 bits; o ULP usa os 16 bits baixos).
+// Cada palavra tem um único escritor: o ULP nunca faz leitura-modificação-escrita
+// numa palavra que os núcleos principais também escrevem.
+enum {
+    VAR_RAINING,        // rain_detect_state_t.raining
+    VAR_LDR_REF,        // rain_detect_state_t.ldr_ref
+    VAR_COUNT,          // Leituras feitas (módulo 2^16); a posição no anel é count & BUF_MASK
+    VAR_RAIN_SEQ,       // Eventos de início de chuva (contador do ULP)
+    VAR_LIGHT_SEQ,      // Eventos de mudança de luz (contador do ULP)
+    VAR_EVENT_SEQ,      // Total de eventos, incrementado depois do contador do tipo
+    VAR_EVENT_ACK,      // VAR_EVENT_SEQ já lido pelos núcleos principais (só eles escrevem)
+    VAR_LAST_CHUVA,
+    VAR_LAST_LDR,
+    VAR_LAST_KY028,
+    VAR_BUF,            // Anel: CONFIG_STATION_ULP_BUFFER_LEN trincas (chuva, ldr, ky028)
+};
+
+#define BUF_WORDS       (3 * CONFIG_STATION_ULP_BUFFER_LEN)
+#define BUF_MASK        (CONFIG_STATION_ULP_BUFFER_LEN - 1)
+#define PROG_ADDR       (VAR_BUF + BUF_WORDS)   // O programa vem depois dos dados
+#define PROG_MAX_WORDS  96
+#define ULP_ADC1_CHANNEL_MAX 7
+
+_Static_assert((PROG_ADDR + PROG_MAX_WORDS) * 4 <= CONFIG_ULP_COPROC_RESERVE_MEM,
+               "Aumente CONFIG_ULP_COPROC_RESERVE_MEM ou reduza CONFIG_STATION_ULP_BUFFER_LEN");
+_Static_assert((CONFIG_STATION_ULP_BUFFER_LEN & BUF_MASK) == 0,
+               "CONFIG_STATION_ULP_BUFFER_LEN deve ser potência de 2");
+_Static_assert(CONFIG_STATION_RAIN_OFF > CONFIG_STATION_RAIN_ON,
+               "O limiar de fim de chuva deve ser maior que o de início");
+
+static const char *TAG = "ULP_SENSE";
+
+static volatile uint32_t *const s_rtc = (volatile uint32_t *)SOC_RTC_DATA_LOW;
+static TaskHandle_t s_task;
+static uint16_t s_read_count;   // Valor de VAR_COUNT na última leitura do anel
+static uint16_t s_rain_seen;    // Valores de VAR_RAIN_SEQ e VAR_LIGHT_SEQ na última leitura
+static uint16_t s_light_seen;
+
+// Rótulos do programa
+enum { L_RAINING, L_LIGHT, L_NEG, L_ABS, L_WAKE_CHECK, L_DONE };
+
+// Interrupção do ULP (instrução WAKE com os núcleos acordados)
+static void IRAM_ATTR ulp_isr(void *arg) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+static inline uint16_t rtc_get(unsigned addr) {
+    return s_rtc[addr] & 0xFFFF;
+}
+
+esp_err_t ulp_sense_start(TaskHandle_t task, int chuva_ch, int ldr_ch, int ky028_ch) {
+    // A instrução ADC do ULP só alcança os canais 0 a 7 do ADC1
+    const struct {
+        const char *name;
+        int ch;
+    } channels[] = {{"chuva", chuva_ch}, {"LDR", ldr_ch}, {"KY-028", ky028_ch}};
+    for (size_t i = 0; i < sizeof(channels) / sizeof(channels[0]); i++) {
+        if (channels[i].ch < 0 || channels[i].ch > ULP_ADC1_CHANNEL_MAX) {
+            ESP_LOGE(TAG, "Sensor de %s sem canal do ADC1 (%d) na tabela de sensores: o modo ULP exige uma linha "
+                     "SENSOR_ADC", channels[i].name, channels[i].ch);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // Tradução de rain_detect_step() para o ULP: R3 = base dos dados, R0 = comparações
+    const ulp_insn_t program[] = {
+        I_MOVI(R3, 0),
+
+        // Lê os canais e guarda a última leitura
+        I_ADC(R0, 0, chuva_ch),
+        I_ST(R0, R3, VAR_LAST_CHUVA),
+        I_ADC(R0, 0, ldr_ch),
+        I_ST(R0, R3, VAR_LAST_LDR),
+        I_ADC(R0, 0, ky028_ch),
+        I_ST(R0, R3, VAR_LAST_KY028),
+
+        // Grava a trinca no anel (R2 = (count & mask) * 3) e só então publica o
+        // novo total, que os núcleos principais leem numa única palavra
+        I_LD(R1, R3, VAR_COUNT),
+        I_ANDI(R1, R1, BUF_MASK),
+        I_LSHI(R2, R1, 1),
+        I_ADDR(R2, R2, R1),
+        I_LD(R0, R3, VAR_LAST_CHUVA),
+        I_ST(R0, R2, VAR_BUF + 0),
+        I_LD(R0, R3, VAR_LAST_LDR),
+        I_ST(R0, R2, VAR_BUF + 1),
+        I_LD(R0, R3, VAR_LAST_KY028),
+        I_ST(R0, R2, VAR_BUF + 2),
+        I_LD(R0, R3, VAR_COUNT),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_COUNT),
+
+        // Chuva com histerese
+        I_LD(R0, R3, VAR_RAINING),
+        M_BGE(L_RAINING, 1),
+        I_LD(R0, R3, VAR_LAST_CHUVA),
+        M_BGE(L_LIGHT, CONFIG_STATION_RAIN_ON + 1),     // chuva > rain_on: segue seco
+        I_MOVI(R0, 1),
+        I_ST(R0, R3, VAR_RAINING),
+        I_LD(R0, R3, VAR_RAIN_SEQ),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_RAIN_SEQ),
+        I_LD(R0, R3, VAR_EVENT_SEQ),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_EVENT_SEQ),
+        M_BX(L_LIGHT),
+        M_LABEL(L_RAINING),
+        I_LD(R0, R3, VAR_LAST_CHUVA),
+        M_BL(L_LIGHT, CONFIG_STATION_RAIN_OFF),         // chuva < rain_off: segue chovendo
+        I_MOVI(R0, 0),
+        I_ST(R0, R3, VAR_RAINING),
+
+        // Luz: |ldr - ref| >= delta
+        M_LABEL(L_LIGHT),
+        I_LD(R1, R3, VAR_LAST_LDR),
+        I_LD(R2, R3, VAR_LDR_REF),
+        I_SUBR(R0, R1, R2),
+        M_BXF(L_NEG),                                       // ldr < ref
+        M_BX(L_ABS),
+        M_LABEL(L_NEG),
+        I_SUBR(R0, R2, R1),
+        M_LABEL(L_ABS),
+        M_BL(L_WAKE_CHECK, CONFIG_STATION_LIGHT_DELTA),
+        I_ST(R1, R3, VAR_LDR_REF),
+        I_LD(R0, R3, VAR_LIGHT_SEQ),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_LIGHT_SEQ),
+        I_LD(R0, R3, VAR_EVENT_SEQ),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, VAR_EVENT_SEQ),
+
+        // Acorda os núcleos enquanto houver eventos não confirmados
+        M_LABEL(L_WAKE_CHECK),
+        I_LD(R0, R3, VAR_EVENT_SEQ),
+        I_LD(R1, R3, VAR_EVENT_ACK),
+        I_SUBR(R0, R0, R1),
+        M_BXZ(L_DONE),
+        I_WAKE(),
+        M_LABEL(L_DONE),
+        I_HALT(),
+    };
+
+    for (unsigned i = 0; i < PROG_ADDR; i++) {
+        s_rtc[i] = 0;
+    }
+    s_read_count = s_rain_seen = s_light_seen = 0;
+    s_task = task;
+
+    size_t size = sizeof(program) / sizeof(ulp_insn_t);
+    esp_err_t err = ulp_process_macros_and_load(PROG_ADDR, program, &size);
+    if (err != ESP_OK) return err;
+    if (size > PROG_MAX_WORDS) {
+        ESP_LOGE(TAG, "Programa do ULP com %u palavras, limite %d", (unsigned)size, PROG_MAX_WORDS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_ERROR_CHECK(ulp_isr_register(ulp_isr, NULL));
+    ESP_ERROR_CHECK(esp_sleep_enable_ulp_wakeup()); // Também acorda de light sleep
+    ulp_set_wakeup_period(0, CONFIG_STATION_ULP_PERIOD_MS * 1000);
+    err = ulp_run(PROG_ADDR);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "ULP amostrando a cada %d ms (%u palavras de programa)",
+                 CONFIG_STATION_ULP_PERIOD_MS, (unsigned)size);
+    }
+    return err;
+}
+
+size_t ulp_sense_drain(ulp_sense_reading_t *out, unsigned *events) {
+    // O total vem antes dos contadores por tipo, que o ULP incrementa primeiro:
+    // todo evento incluído em seq já aparece no seu contador. Um evento que
+    // chegue entre as leituras é informado agora ou, por não estar na
+    // confirmação, acorda a estação de novo; nunca se perde.
+    uint16_t seq = rtc_get(VAR_EVENT_SEQ);
+    uint16_t rain = rtc_get(VAR_RAIN_SEQ);
+    uint16_t light = rtc_get(VAR_LIGHT_SEQ);
+    *events = (rain != s_rain_seen ? RAIN_DETECT_EVENT_RAIN : 0) | (light != s_light_seen ? RAIN_DETECT_EVENT_LIGHT : 0);
+    s_rain_seen = rain;
+    s_light_seen = light;
+    s_rtc[VAR_EVENT_ACK] = seq;
+
+    // A posição de cada leitura sai do próprio total, lido numa única palavra
+    uint16_t count = rtc_get(VAR_COUNT);
+    uint16_t n = count - s_read_count;
+    if (n > BUF_MASK) {
+        // As mais antigas já foram sobrescritas. Uma posição de folga: a
+        // próxima gravação do ULP pode cair na mais antiga durante a cópia
+        n = BUF_MASK;
+    }
+    s_read_count = count;
+
+    unsigned slot = (uint16_t)(count - n) & BUF_MASK;
+    for (unsigned i = 0; i < n; i++) {
+        unsigned addr = VAR_BUF + 3 * slot;
+        out[i] = (ulp_sense_reading_t){
+            .chuva_raw = rtc_get(addr),
+            .ldr_raw = rtc_get(addr + 1),
+            .ky028_raw = rtc_get(addr + 2),
+        };
+        slot = (slot + 1) & BUF_MASK;
+    }
+    return n;
+}
+
+void ulp_sense_latest(ulp_sense_reading_t *out) {
+    out->chuva_raw = rtc_get(VAR_LAST_CHUVA);
+    out->ldr_raw = rtc_get(VAR_LAST_LDR);
+    out->ky028_raw = rtc_get(VAR_LAST_KY028);
+}
+
+#endif // CONFIG_STATION_ULP_SENSE
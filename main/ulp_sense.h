@@ -0,0 +1,44 @@
+#ifndef ULP_SENSE_H
+#define ULP_SENSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+// Amostragem dos canais analógicos pelo coprocessador ULP: a cada
+// CONFIG_STATION_ULP_PERIOD_MS o ULP lê chuva, LDR e KY-028, guarda as leituras
+// num anel na memória RTC e aplica os limiares de rain_detect.h. Os núcleos
+// principais só são acordados no início de uma chuva ou numa mudança brusca de
+// luz; as demais leituras esperam no anel até o próximo ciclo da estação.
+
+#if CONFIG_STATION_ULP_SENSE
+
+typedef struct {
+    uint16_t chuva_raw;
+    uint16_t ldr_raw;
+    uint16_t ky028_raw;
+} ulp_sense_reading_t;
+
+// Carrega o programa do ULP para os canais do ADC1 indicados e inicia a
+// amostragem. A tarefa `task` recebe uma notificação (xTaskNotifyGive) a cada
+// evento. O ADC1 deve ter sido criado com ulp_mode = ADC_ULP_MODE_FSM e os
+// canais já configurados. Retorna ESP_ERR_INVALID_ARG se algum canal não for
+// do ADC1 (por exemplo -1 de sensors_adc_channel() para um campo sem linha ADC).
+esp_err_t ulp_sense_start(TaskHandle_t task, int chuva_ch, int ldr_ch, int ky028_ch);
+
+// Copia para out as leituras feitas desde a chamada anterior (no máximo
+// CONFIG_STATION_ULP_BUFFER_LEN - 1, as mais recentes) e retorna quantas foram.
+// Em *events ficam os eventos ocorridos desde a chamada anterior, que são
+// confirmados ao ULP.
+size_t ulp_sense_drain(ulp_sense_reading_t *out, unsigned *events);
+
+// Última leitura feita pelo ULP
+void ulp_sense_latest(ulp_sense_reading_t *out);
+
+#endif // CONFIG_STATION_ULP_SENSE
+
+#endif // ULP_SENSE_H
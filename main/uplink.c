@@ -0,0 +1,443 @@
+#include "uplink.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "backfill.h"
+#include "latency.h"
+
+// Acima desta ocupação do outbox (3/4 do limite) só 1 em cada
+// CONFIG_STATION_UPLINK_DECIMATE amostras é publicada e o backfill aguarda
+#define OUTBOX_HIGH_WATER   ((CONFIG_STATION_MQTT_OUTBOX_LIMIT * 3) / 4)
+#define STATS_PERIOD_MS     60000   // Intervalo mínimo entre relatórios dos contadores
+#define RETRY_MS            1000    // Nova tentativa de backfill após falha no enqueue
+#define NO_DEADLINE         INT64_MAX
+#define PAYLOAD_MAX         STATION_JSON_MAX // Maior JSON de uma amostra
+
+#if CONFIG_STATION_MQTT5_TOPIC_ALIAS
+#define DATA_TOPIC_ALIAS    1       // Alias do tópico de dados (0 = sem alias)
+#else
+#define DATA_TOPIC_ALIAS    0
+#endif
+
+static const char *TAG = "UPLINK";
+
+static QueueHandle_t s_queue;                       // Fila station_task -> uplink_task
+static TaskHandle_t s_task;                         // uplink_task, acordada por notificação
+#if CONFIG_STATION_STATIC_ALLOC
+static StaticQueue_t s_queue_buf;
+static uint8_t s_queue_storage[CONFIG_STATION_UPLINK_QUEUE_LEN * sizeof(station_sample_t)];
+static StaticTask_t s_task_buf;
+static StackType_t s_task_stack[CONFIG_STATION_UPLINK_TASK_STACK];
+#endif
+static esp_mqtt_client_handle_t volatile s_client;  // Cliente MQTT atual
+static const char *s_topic;                         // Tópico de publicação
+static const char *s_backfill_topic;                // Tópico dos blocos comprimidos
+static atomic_bool s_connected;                     // Conexão com o broker ativa
+
+static atomic_uint s_queued;
+static atomic_uint s_acked;
+static atomic_uint s_dropped;
+static atomic_uint s_decimated;
+static atomic_uint s_backfilled;
+static atomic_uint s_backfill_blocks;
+static int64_t s_last_defer_ms;                     // Última amostra desviada para o backfill (uplink_task)
+static atomic_bool s_drain_blocked;                 // Backfill aguardando folga no outbox
+
+// Mensagens aguardando PUBACK, para medir a latência captura -> broker
+typedef struct {
+    int msg_id;             // 0 = posição livre
+    int64_t captured_ms;
+} inflight_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED; // Protege a tabela e o histograma de PUBACK
+static inflight_t s_inflight[CONFIG_STATION_LATENCY_TRACK_LEN];
+static unsigned s_inflight_next;
+static latency_hist_t s_ack_hist;       // Captura -> PUBACK
+static latency_hist_t s_enqueue_hist;   // Captura -> outbox (só a uplink_task escreve)
+
+#if CONFIG_MQTT_PROTOCOL_5
+static atomic_uint s_conn_gen;          // Incrementado a cada conexão com o broker
+static unsigned s_alias_gen;            // Conexão em que o estado do alias vale (uplink_task)
+static bool s_alias_set;                // Broker já recebeu o tópico completo com o alias
+static bool s_alias_off;                // Alias recusado nesta conexão
+static char s_alias_json[PAYLOAD_MAX];  // Última amostra publicada no tópico de dados (protegida por s_lock)
+static int s_alias_json_len;
+// As propriedades de publicação ficam numa única área do cliente até a
+// publicação seguinte: esta trava cobre cada par set_properties() + publicação
+static SemaphoreHandle_t s_pub_mutex;
+#if CONFIG_STATION_STATIC_ALLOC
+static StaticSemaphore_t s_pub_mutex_buf;
+#endif
+// Últimas propriedades definidas pela uplink_task (protegidas por s_lock), para
+// o evento de conexão devolvê-las à área do cliente depois do reanúncio
+static esp_mqtt5_publish_property_config_t s_props;
+#endif
+
+static int64_t now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+// Guarda o instante de captura da mensagem até o PUBACK chegar. Com a tabela
+// cheia a entrada mais antiga é sobrescrita e deixa de ser medida.
+static void track(int msg_id, int64_t captured_ms) {
+    taskENTER_CRITICAL(&s_lock);
+    s_inflight[s_inflight_next++ % CONFIG_STATION_LATENCY_TRACK_LEN] = (inflight_t){msg_id, captured_ms};
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+// Remove a mensagem da tabela; com `acked` registra a latência até o PUBACK
+static void untrack(int msg_id, bool acked) {
+    int64_t now = now_ms();
+    taskENTER_CRITICAL(&s_lock);
+    for (unsigned i = 0; i < CONFIG_STATION_LATENCY_TRACK_LEN; i++) {
+        if (s_inflight[i].msg_id == msg_id) {
+            if (acked) {
+                latency_hist_add(&s_ack_hist, (uint32_t)(now - s_inflight[i].captured_ms));
+            }
+            s_inflight[i].msg_id = 0;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+#if CONFIG_MQTT_PROTOCOL_5
+// Define as propriedades da próxima publicação da uplink_task (valem para uma só)
+static void set_properties(esp_mqtt_client_handle_t c, const char *content_type,
+                           uint32_t expiry_s, uint16_t alias) {
+    esp_mqtt5_publish_property_config_t prop = {
+        .message_expiry_interval = expiry_s,
+        .topic_alias = alias,
+        .content_type = content_type,
+    };
+    taskENTER_CRITICAL(&s_lock);
+    s_props = prop;
+    taskEXIT_CRITICAL(&s_lock);
+    esp_mqtt5_client_set_publish_property(c, &prop);
+}
+
+// Guarda a amostra para um eventual reanúncio. Chamada depois de cada amostra
+// aceita no tópico de dados, antes da próxima só com o alias: toda mensagem
+// só com o alias no outbox tem, portanto, uma amostra guardada.
+static void remember_sample(const char *payload, int len) {
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(s_alias_json, payload, len);
+    s_alias_json_len = len;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+// O alias só existe na conexão em que foi definido, mas as mensagens publicadas
+// apenas com ele podem continuar no outbox e ser reenviadas na conexão seguinte.
+// Chamada no evento de conexão, antes de o cliente voltar ao outbox: republica
+// com QoS 0 a última amostra com o tópico completo, restabelecendo o alias.
+// Com `restore` a uplink_task pode estar entre set_properties() e a
+// publicação (esperando pela trava do cliente, que o evento segura); as
+// propriedades dela voltam à área do cliente antes de ela prosseguir.
+static void announce_alias(esp_mqtt_client_handle_t c, bool restore) {
+    char payload[PAYLOAD_MAX];
+    taskENTER_CRITICAL(&s_lock);
+    int len = s_alias_json_len;
+    memcpy(payload, s_alias_json, len);
+    taskEXIT_CRITICAL(&s_lock);
+    if (!c || len == 0) return;
+    esp_mqtt5_publish_property_config_t prop = {
+        .message_expiry_interval = CONFIG_STATION_MQTT5_MSG_EXPIRY,
+        .topic_alias = DATA_TOPIC_ALIAS,
+        .content_type = UPLINK_CONTENT_TYPE_JSON,
+    };
+    esp_mqtt5_client_set_publish_property(c, &prop);
+    esp_mqtt_client_publish(c, s_topic, payload, len, 0, 0);
+    if (restore) {
+        taskENTER_CRITICAL(&s_lock);
+        prop = s_props;
+        taskEXIT_CRITICAL(&s_lock);
+        esp_mqtt5_client_set_publish_property(c, &prop);
+    }
+}
+
+static void pub_lock(void) {
+    xSemaphoreTake(s_pub_mutex, portMAX_DELAY);
+}
+
+static void pub_unlock(void) {
+    xSemaphoreGive(s_pub_mutex);
+}
+#else
+static inline void pub_lock(void) {}
+static inline void pub_unlock(void) {}
+#endif
+
+// Coloca uma amostra no outbox. No MQTT 5 a primeira mensagem de cada conexão
+// leva o tópico completo e o alias; as seguintes, só o alias (tópico vazio).
+// Chamada com pub_lock().
+static int publish_sample(esp_mqtt_client_handle_t c, const char *payload, int len) {
+#if CONFIG_MQTT_PROTOCOL_5
+    unsigned gen = atomic_load(&s_conn_gen);
+    if (gen != s_alias_gen) {
+        s_alias_gen = gen;
+        s_alias_set = false;
+        s_alias_off = DATA_TOPIC_ALIAS == 0;
+    }
+    if (!s_alias_off) {
+        set_properties(c, UPLINK_CONTENT_TYPE_JSON, CONFIG_STATION_MQTT5_MSG_EXPIRY, DATA_TOPIC_ALIAS);
+        int msg_id = esp_mqtt_client_enqueue(c, s_alias_set ? "" : s_topic, payload, len, 1, 0, true);
+        if (msg_id >= 0) {
+            remember_sample(payload, len);
+            s_alias_set = true;
+            return msg_id;
+        }
+        if (msg_id != -1 || s_alias_set) return msg_id; // Falha sem relação com o alias
+        // O esp-mqtt não expõe o Topic Alias Maximum do CONNACK, mas recusa com
+        // -1 um alias acima dele. Na primeira amostra da conexão a mesma
+        // mensagem é tentada sem o alias: só se ela passar o alias é a causa.
+        set_properties(c, UPLINK_CONTENT_TYPE_JSON, CONFIG_STATION_MQTT5_MSG_EXPIRY, 0);
+        msg_id = esp_mqtt_client_enqueue(c, s_topic, payload, len, 1, 0, true);
+        if (msg_id >= 0) {
+            ESP_LOGW(TAG, "Broker não aceita o alias de tópico; publicando com o tópico completo nesta conexão");
+            s_alias_off = true;
+        }
+        return msg_id;
+    }
+    set_properties(c, UPLINK_CONTENT_TYPE_JSON, CONFIG_STATION_MQTT5_MSG_EXPIRY, 0);
+#endif
+    // enqueue só grava no outbox; o envio fica a cargo da tarefa do cliente
+    return esp_mqtt_client_enqueue(c, s_topic, payload, len, 1, 0, true);
+}
+
+// Decide se a amostra segue para o outbox conforme a ocupação atual
+static bool admit(esp_mqtt_client_handle_t c, unsigned *decimate_count) {
+    if (!c || !atomic_load(&s_connected)) {
+        return false; // Sem broker: a amostra vai para o backfill
+    }
+    int outbox = esp_mqtt_client_get_outbox_size(c);
+    if (outbox >= CONFIG_STATION_MQTT_OUTBOX_LIMIT) {
+        return false; // Outbox cheio: a amostra vai para o backfill
+    }
+    if (outbox >= OUTBOX_HIGH_WATER) {
+        // Broker lento: publica apenas 1 a cada N amostras, as demais vão para o backfill
+        if ((*decimate_count)++ % CONFIG_STATION_UPLINK_DECIMATE != 0) {
+            atomic_fetch_add(&s_decimated, 1);
+            return false;
+        }
+    } else {
+        *decimate_count = 0;
+    }
+    return true;
+}
+
+// Guarda no histórico comprimido uma amostra que não foi publicada
+static void defer(const station_sample_t *sample) {
+    s_last_defer_ms = now_ms();
+    atomic_fetch_add(&s_backfilled, 1);
+    unsigned lost = backfill_push(sample);
+    if (lost) {
+        atomic_fetch_add(&s_dropped, lost); // Anel de backfill cheio
+    }
+}
+
+// Publica os blocos de backfill pendentes enquanto o outbox tiver folga. O
+// bloco aberto só é fechado depois de CONFIG_STATION_BACKFILL_FLUSH_S sem
+// desvios, para que uma queda curta não vire um bloco de uma só amostra.
+// Retorna o instante (ms) da próxima tentativa, ou NO_DEADLINE se a uplink_task
+// pode esperar por uma notificação (conexão, PUBACK ou nova amostra).
+static int64_t drain_backfill(esp_mqtt_client_handle_t c) {
+    if (!c || !atomic_load(&s_connected)) return NO_DEADLINE;
+    int64_t flush_at = s_last_defer_ms + CONFIG_STATION_BACKFILL_FLUSH_S * 1000;
+    while (1) {
+        if (esp_mqtt_client_get_outbox_size(c) >= OUTBOX_HIGH_WATER) {
+            atomic_store(&s_drain_blocked, true); // O próximo PUBACK acorda a tarefa
+            return NO_DEADLINE;
+        }
+        size_t len;
+        const uint8_t *block = backfill_peek(&len, now_ms() >= flush_at);
+        if (!block) {
+            // Só resta o bloco aberto (ou nada): volta quando puder fechá-lo
+            return backfill_pending() > 0 ? flush_at : NO_DEADLINE;
+        }
+        pub_lock();
+#if CONFIG_MQTT_PROTOCOL_5
+        set_properties(c, UPLINK_CONTENT_TYPE_TSBLOCK, 0, 0); // Histórico não expira
+#endif
+        int msg_id = esp_mqtt_client_enqueue(c, s_backfill_topic, (const char *)block, len, 1, 0, true);
+        pub_unlock();
+        if (msg_id < 0) {
+            return now_ms() + RETRY_MS;
+        }
+        backfill_pop();
+        atomic_fetch_add(&s_backfill_blocks, 1);
+    }
+}
+
+// Tarefa que consome a fila e alimenta o outbox do cliente MQTT. Fica
+// bloqueada até uma notificação ou o próximo prazo do backfill, sem acordar
+// periodicamente, para não encurtar o light sleep.
+static void uplink_task(void *pvParameters) {
+    station_sample_t sample;
+    char payload[PAYLOAD_MAX];
+    unsigned decimate_count = 0;
+    TickType_t last_report = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        while (xQueueReceive(s_queue, &sample, 0) == pdTRUE) {
+            esp_mqtt_client_handle_t c = s_client;
+            if (admit(c, &decimate_count)) {
+                int len = station_format_json(payload, sizeof(payload), &sample);
+                pub_lock();
+                int msg_id = publish_sample(c, payload, len);
+                pub_unlock();
+                if (msg_id < 0) {
+                    defer(&sample);
+                } else {
+                    atomic_fetch_add(&s_queued, 1);
+                    latency_hist_add(&s_enqueue_hist, (uint32_t)(now_ms() - sample.timestamp_ms));
+                    track(msg_id, sample.timestamp_ms);
+                }
+            } else {
+                defer(&sample);
+            }
+        }
+        atomic_store(&s_drain_blocked, false);
+        int64_t next = drain_backfill(s_client);
+        if (next == NO_DEADLINE) {
+            wait = portMAX_DELAY;
+        } else {
+            int64_t ms = next - now_ms();
+            wait = ms > 0 ? pdMS_TO_TICKS(ms) + 1 : 0;
+        }
+
+        // Relatório dos contadores de pressão, na primeira passagem após o
+        // período (sem prazo próprio: as amostras já acordam a tarefa)
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(STATS_PERIOD_MS)) {
+            last_report = xTaskGetTickCount();
+            uplink_stats_t st;
+            uplink_get_stats(&st);
+            ESP_LOGI(TAG, "enfileiradas:%u | confirmadas:%u | descartadas:%u | dizimadas:%u | outbox:%d bytes",
+                     (unsigned)st.queued, (unsigned)st.acked, (unsigned)st.dropped,
+                     (unsigned)st.decimated, st.outbox_bytes);
+            ESP_LOGI(TAG, "backfill: comprimidas:%u | blocos enviados:%u | pendentes:%u",
+                     (unsigned)st.backfilled, (unsigned)st.backfill_blocks,
+                     (unsigned)st.backfill_pending);
+            ESP_LOGI(TAG, "latência (ms): captura->outbox p99:%u | captura->PUBACK p50:%u p90:%u p99:%u max:%u",
+                     (unsigned)st.enqueue_p99_ms, (unsigned)st.ack_p50_ms, (unsigned)st.ack_p90_ms,
+                     (unsigned)st.ack_p99_ms, (unsigned)st.ack_max_ms);
+        }
+    }
+}
+
+void uplink_init(const char *topic, const char *backfill_topic) {
+    s_topic = topic;
+    s_backfill_topic = backfill_topic;
+#if CONFIG_MQTT_PROTOCOL_5
+#if CONFIG_STATION_STATIC_ALLOC
+    s_pub_mutex = xSemaphoreCreateMutexStatic(&s_pub_mutex_buf);
+#else
+    s_pub_mutex = xSemaphoreCreateMutex();
+#endif
+#endif
+    // Prioridade abaixo da station_task para nunca competir com a amostragem
+#if CONFIG_STATION_STATIC_ALLOC
+    s_queue = xQueueCreateStatic(CONFIG_STATION_UPLINK_QUEUE_LEN, sizeof(station_sample_t),
+                                 s_queue_storage, &s_queue_buf);
+    s_task = xTaskCreateStatic(uplink_task, "uplink_task", CONFIG_STATION_UPLINK_TASK_STACK, NULL, 4,
+                      s_task_stack, &s_task_buf);
+#else
+    s_queue = xQueueCreate(CONFIG_STATION_UPLINK_QUEUE_LEN, sizeof(station_sample_t));
+    xTaskCreate(uplink_task, "uplink_task", CONFIG_STATION_UPLINK_TASK_STACK, NULL, 4, &s_task);
+#endif
+}
+
+void uplink_set_client(esp_mqtt_client_handle_t client) {
+    s_client = client;
+}
+
+void uplink_set_connected(bool connected) {
+#if CONFIG_MQTT_PROTOCOL_5
+    if (connected) {
+        atomic_fetch_add(&s_conn_gen, 1); // Aliases da conexão anterior deixam de valer
+        // O evento roda na tarefa do cliente MQTT, que segura a trava interna
+        // do cliente; esperar aqui pela uplink_task (que pode estar esperando
+        // por essa trava) travaria as duas. O reanúncio não pode ser adiado:
+        // o cliente reenvia o outbox logo depois deste evento. Com a trava
+        // livre e o outbox vazio nenhuma mensagem só com o alias será
+        // reenviada, e a próxima amostra já leva o tópico completo; sem a
+        // trava a uplink_task pode ter lido a conexão anterior e estar
+        // gravando uma delas, então o reanúncio é feito de qualquer forma.
+        if (xSemaphoreTake(s_pub_mutex, 0) == pdTRUE) {
+            if (esp_mqtt_client_get_outbox_size(s_client) > 0) {
+                announce_alias(s_client, false);
+            }
+            xSemaphoreGive(s_pub_mutex);
+        } else {
+            announce_alias(s_client, true);
+        }
+    }
+#endif
+    atomic_store(&s_connected, connected);
+    if (connected) {
+        xTaskNotifyGive(s_task); // Envia o backfill acumulado durante a queda
+    }
+}
+
+bool uplink_submit(const station_sample_t *sample) {
+    bool ok = xQueueSend(s_queue, sample, 0) == pdTRUE;
+    if (!ok) {
+        // Fila cheia: descarta a amostra mais antiga para manter os dados recentes
+        station_sample_t oldest;
+        if (xQueueReceive(s_queue, &oldest, 0) == pdTRUE) {
+            atomic_fetch_add(&s_dropped, 1);
+        }
+        xQueueSend(s_queue, sample, 0);
+    }
+    xTaskNotifyGive(s_task);
+    return ok;
+}
+
+// Folga nova no outbox: acorda a uplink_task se o backfill estava esperando por ela
+static void outbox_released(void) {
+    if (atomic_exchange(&s_drain_blocked, false)) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void uplink_on_published(int msg_id) {
+    atomic_fetch_add(&s_acked, 1);
+    untrack(msg_id, true);
+    outbox_released();
+}
+
+void uplink_on_deleted(int msg_id) {
+    atomic_fetch_add(&s_dropped, 1); // Mensagem expirou no outbox sem confirmação
+    untrack(msg_id, false);
+    outbox_released();
+}
+
+void uplink_get_stats(uplink_stats_t *out) {
+    esp_mqtt_client_handle_t c = s_client;
+    out->queued = atomic_load(&s_queued);
+    out->acked = atomic_load(&s_acked);
+    out->dropped = atomic_load(&s_dropped);
+    out->decimated = atomic_load(&s_decimated);
+    out->backfilled = atomic_load(&s_backfilled);
+    out->backfill_blocks = atomic_load(&s_backfill_blocks);
+    out->backfill_pending = backfill_pending();
+    out->enqueue_p99_ms = latency_hist_percentile(&s_enqueue_hist, 99);
+
+    taskENTER_CRITICAL(&s_lock);
+    out->ack_p50_ms = latency_hist_percentile(&s_ack_hist, 50);
+    out->ack_p90_ms = latency_hist_percentile(&s_ack_hist, 90);
+    out->ack_p99_ms = latency_hist_percentile(&s_ack_hist, 99);
+    out->ack_max_ms = s_ack_hist.max_ms;
+    taskEXIT_CRITICAL(&s_lock);
+    out->outbox_bytes = c ? esp_mqtt_client_get_outbox_size(c) : 0;
+}
@@ -0,0 +1,66 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mqtt_client.h"
+#include "station.h"
+
+// Publicador MQTT assíncrono: a station_task apenas entrega as amostras numa
+// fila limitada e uma tarefa de menor prioridade as coloca no outbox do cliente
+// com esp_mqtt_client_enqueue(), sem nunca esperar pela rede. Amostras que não
+// podem ser publicadas (broker fora ou lento) são comprimidas no backfill e
+// enviadas em blocos binários quando houver folga.
+//
+// Com CONFIG_MQTT_PROTOCOL_5 as mensagens levam as propriedades Content Type
+// (JSON ou bloco binário), Message Expiry (amostras) e, no tópico de dados,
+// Topic Alias no lugar do nome do tópico.
+
+// Content Type das mensagens no MQTT 5
+#define UPLINK_CONTENT_TYPE_JSON    "application/json"
+#define UPLINK_CONTENT_TYPE_TSBLOCK "application/x-tsblock"
+
+// Contadores de pressão e latência do publicador
+typedef struct {
+    uint32_t queued;            // Mensagens aceitas no outbox do cliente MQTT
+    uint32_t acked;             // Mensagens confirmadas pelo broker (PUBACK)
+    uint32_t dropped;           // Amostras perdidas (fila cheia, backfill cheio ou expiradas)
+    uint32_t decimated;         // Amostras desviadas para o backfill pela dizimação
+    uint32_t backfilled;        // Amostras comprimidas no backfill
+    uint32_t backfill_blocks;   // Blocos de backfill enviados ao outbox
+    uint32_t backfill_pending;  // Amostras aguardando no backfill
+    int outbox_bytes;           // Ocupação atual do outbox em bytes
+    uint32_t enqueue_p99_ms;    // Latência captura -> outbox, percentil 99
+    uint32_t ack_p50_ms;        // Latência captura -> PUBACK, percentis e máximo
+    uint32_t ack_p90_ms;
+    uint32_t ack_p99_ms;
+    uint32_t ack_max_ms;
+} uplink_stats_t;
+
+// Cria a fila e a tarefa do publicador para os tópicos de dados e de backfill
+void uplink_init(const char *topic, const char *backfill_topic);
+
+// Define o cliente MQTT usado pelo publicador (NULL suspende as publicações)
+void uplink_set_client(esp_mqtt_client_handle_t client);
+
+// Informa se o cliente está conectado ao broker. Deve ser chamada no
+// mqtt_event_handler: no MQTT 5 a conexão nova restabelece ali o alias do
+// tópico de dados antes que o cliente reenvie o outbox, republicando a última
+// amostra (o assinante a recebe de novo, com o mesmo "seq").
+void uplink_set_connected(bool connected);
+
+// Entrega uma amostra ao publicador sem bloquear. Se a fila estiver cheia, a
+// amostra mais antiga é descartada. Retorna false se houve descarte.
+bool uplink_submit(const station_sample_t *sample);
+
+// Chamadas a partir do mqtt_event_handler. O evento MQTT_EVENT_DELETED (mensagem
+// expirada no outbox) só é gerado com CONFIG_MQTT_REPORT_DELETED_MESSAGES,
+// habilitada no sdkconfig do projeto.
+void uplink_on_published(int msg_id);
+void uplink_on_deleted(int msg_id);
+
+// Copia os contadores atuais
+void uplink_get_stats(uplink_stats_t *out);
+
+#endif // UPLINK_H
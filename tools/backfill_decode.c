@@ -0,0 +1,81 @@
+// Decodificador de blocos de backfill da estação (ferramenta do host)
+//
+// Lê blocos comprimidos publicados no tópico de backfill e imprime uma linha
+// JSON por amostra, no mesmo formato do tópico de dados.
+// Aceita vários blocos concatenados em um mesmo arquivo.
+//
+// Compilação:
+//   gcc -O2 -Imain -o backfill_decode tools/backfill_decode.c main/tsblock.c main/station.c -lm
+//
+// Uso:
+//   mosquitto_sub -h <broker> -t /ifpe/ads/embarcados/esp32/station/backfill -N > blocos.bin
+//   ./backfill_decode blocos.bin
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tsblock.h"
+
+#define MAX_INPUT (16 * 1024 * 1024)
+
+// Imprime as amostras de todos os blocos em buf e acumula as estatísticas
+static void decode_stream(const uint8_t *buf, size_t len, size_t *blocks, size_t *samples,
+                          size_t *block_bytes, size_t *json_bytes) {
+    size_t off = 0;
+    while (off < len) {
+        tsblock_decoder_t d;
+        if (!tsblock_decoder_init(&d, buf + off, len - off)) {
+            // Separadores entre payloads (ex.: '\n' do mosquitto_sub) são ignorados
+            if (buf[off] == TSBLOCK_MAGIC) {
+                fprintf(stderr, "bloco inválido no offset %zu, procurando o próximo\n", off);
+            }
+            off++;
+            continue;
+        }
+        station_sample_t s;
+        while (tsblock_next(&d, &s)) {
+            // Mesmo JSON publicado no tópico de dados, para comparar os tamanhos
+            char json[STATION_JSON_MAX];
+            int len = station_format_json(json, sizeof(json), &s);
+            if (len >= (int)sizeof(json)) {
+                fprintf(stderr, "amostra seq %lu: JSON truncado em %zu bytes\n", (unsigned long)s.seq, sizeof(json) - 1);
+                len = sizeof(json) - 1; // Conta só o que foi escrito
+            }
+            *json_bytes += len;
+            printf("%s\n", json);
+            (*samples)++;
+        }
+        if (d.remaining) {
+            fprintf(stderr, "bloco truncado no offset %zu\n", off);
+        }
+        (*blocks)++;
+        *block_bytes += d.len;
+        off += d.len;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint8_t *buf = malloc(MAX_INPUT);
+    if (!buf) return 1;
+
+    size_t blocks = 0, samples = 0, block_bytes = 0, json_bytes = 0;
+    for (int i = 1; i < argc || (argc == 1 && i == 1); i++) {
+        FILE *f = argc == 1 ? stdin : fopen(argv[i], "rb");
+        if (!f) {
+            perror(argv[i]);
+            return 1;
+        }
+        size_t len = fread(buf, 1, MAX_INPUT, f);
+        if (f != stdin) fclose(f);
+        decode_stream(buf, len, &blocks, &samples, &block_bytes, &json_bytes);
+    }
+
+    fprintf(stderr, "%zu blocos, %zu amostras, %zu bytes comprimidos, %zu bytes em JSON",
+            blocks, samples, block_bytes, json_bytes);
+    if (block_bytes) {
+        fprintf(stderr, " (%.1fx)", (double)json_bytes / block_bytes);
+    }
+    fprintf(stderr, "\n");
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Decodificador de dumps binários do log diferido (ferramenta do host)
+//
+// Com CONFIG_DLOG_OUTPUT_BINARY a estação escreve na serial os registros
+// brutos do dlog (32 bytes cada, iniciados por DLOG_SYNC), misturados ao texto
+// dos demais logs. Esta ferramenta procura os registros no dump, valida o ID e
+// o número de argumentos e imprime cada mensagem no formato do ESP_LOG. Bytes
+// não textuais entre os registros e marcas de início com cabeçalho inválido
+// são informados na saída de erro, e o código de saída passa a ser 2.
+//
+// Compilação:
+//   gcc -O2 -Icomponents/dlog -o dlog_decode tools/dlog_decode.c components/dlog/dlog_format.c
+//
+// Uso:
+//   cat /dev/ttyUSB0 > dump.bin      (ou qualquer captura crua da serial)
+//   ./dlog_decode dump.bin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlog.h"
+
+// Bytes que aparecem no texto dos demais logs (ESP_LOG, printf)
+static int is_text(uint8_t c) {
+    return (c >= 0x20 && c < 0x7F) || c == '\r' || c == '\n' || c == '\t' || c == 0x1B || c >= 0x80;
+}
+
+// Trecho descartado entre dois registros: texto comum é esperado, mas bytes
+// fora do texto indicam um registro corrompido ou perdido e são informados
+typedef struct {
+    size_t start;       // Posição no dump do primeiro byte do trecho
+    size_t len;
+    size_t binary;      // Bytes que não são texto
+} gap_t;
+
+static void gap_end(gap_t *g, size_t *reported) {
+    if (g->binary) {
+        fprintf(stderr, "offset %zu: %zu bytes ignorados, %zu não textuais (registro corrompido?)\n", g->start,
+                g->len, g->binary);
+        (*reported)++;
+    }
+    g->len = g->binary = 0;
+}
+
+int main(int argc, char **argv) {
+    FILE *f = argc > 1 ? fopen(argv[1], "rb") : stdin;
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // Janela deslizante do tamanho de um registro sobre o dump
+    uint8_t win[sizeof(dlog_record_t)];
+    size_t fill = 0, offset = 0, records = 0, skipped = 0, bad_headers = 0, gaps = 0;
+    gap_t gap = {0};
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        win[fill++] = (uint8_t)c;
+        if (fill < sizeof(win)) continue;
+
+        dlog_record_t rec;
+        memcpy(&rec, win, sizeof(rec));
+        if (rec.sync == DLOG_SYNC && rec.id < DLOG_COUNT && rec.nargs <= DLOG_MAX_ARGS &&
+            rec.nargs == dlog_count_args(dlog_fmt(rec.id))) {
+            gap_end(&gap, &gaps);
+            char msg[256];
+            dlog_format(&rec, msg, sizeof(msg));
+            printf("%c (%lu) %s: %s\n", dlog_level(rec.id), (unsigned long)rec.timestamp_ms,
+                   dlog_tag(rec.id), msg);
+            records++;
+            offset += sizeof(win);
+            fill = 0;
+        } else {
+            if (rec.sync == DLOG_SYNC) {
+                // Marca de início com cabeçalho inválido: registro danificado
+                fprintf(stderr, "offset %zu: registro com cabeçalho inválido (id %u, %u argumentos); ressincronizando\n",
+                        offset, rec.id, rec.nargs);
+                bad_headers++;
+            }
+            // Não é um registro: descarta um byte e tenta na próxima posição
+            if (gap.len == 0) gap.start = offset;
+            gap.len++;
+            gap.binary += !is_text(win[0]);
+            memmove(win, win + 1, sizeof(win) - 1);
+            fill--;
+            offset++;
+            skipped++;
+        }
+    }
+    gap.len += fill;
+    for (size_t i = 0; i < fill; i++) gap.binary += !is_text(win[i]);
+    gap_end(&gap, &gaps);
+    if (f != stdin) fclose(f);
+    fprintf(stderr, "%zu registros decodificados, %zu bytes ignorados (%zu trechos não textuais, %zu cabeçalhos inválidos)\n",
+            records, skipped + fill, gaps, bad_headers);
+    return gaps || bad_headers ? 2 : 0;
+}
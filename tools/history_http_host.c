@@ -0,0 +1,152 @@
+// Servidor HTTP do histórico compilado para o host (ferramenta de teste)
+//
+// Usa os mesmos history.c, rollup.c e history_api.c do firmware, alimentados
+// com amostras sintéticas a cada segundo, para exercitar as rotas /latest,
+// /history, /history.bin e /rollup com um cliente HTTP local.
+//
+// Compilação:
+//   gcc -O2 -Imain -DCONFIG_STATION_HISTORY_LEN=360 -DCONFIG_STATION_ROLLUP_MINUTES=240 -DCONFIG_STATION_ROLLUP_HOURS=168 -o history_http_host tools/history_http_host.c main/history.c main/history_api.c main/rollup.c main/station.c -lm
+//
+// Uso:
+//   ./history_http_host 8080
+//   curl -i localhost:8080/latest
+//   curl -i -H 'If-None-Match: <ETag da resposta anterior>' localhost:8080/history?n=5
+//   curl -i 'localhost:8080/rollup?s=7200&points=60'
+
+#define _GNU_SOURCE // strcasestr
+
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "history_api.h"
+#include "rollup.h"
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Gera uma leitura sintética com variações lentas, como na estação real
+static void push_synthetic(int64_t t) {
+    double x = t / 60000.0;
+    station_sample_t s = {.timestamp_ms = t};
+    s.value[STATION_FIELD_TEMPERATURA] = roundf(25 + 3 * sin(x));
+    s.value[STATION_FIELD_UMIDADE] = roundf(60 + 10 * cos(x));
+    s.value[STATION_FIELD_CHUVA] = rand() % 3;
+    s.value[STATION_FIELD_KY028] = 1800 + rand() % 30;
+    s.value[STATION_FIELD_LUMINOSIDADE] = 70 + rand() % 2;
+    history_push(&s);
+    rollup_push(&s);
+}
+
+// Escreve um chunk no formato Transfer-Encoding: chunked
+static int send_chunk(void *ctx, const void *data, size_t len) {
+    int fd = *(int *)ctx;
+    char hdr[16];
+    int n = snprintf(hdr, sizeof(hdr), "%zx\r\n", len);
+    if (write(fd, hdr, n) != n || write(fd, data, len) != (ssize_t)len || write(fd, "\r\n", 2) != 2) {
+        return -1;
+    }
+    return 0;
+}
+
+static void send_head(int fd, const char *status, const char *type, const char *etag) {
+    dprintf(fd, "HTTP/1.1 %s\r\nETag: %s\r\nCache-Control: no-cache\r\nConnection: close\r\n", status, etag);
+    if (type) {
+        dprintf(fd, "Content-Type: %s\r\nTransfer-Encoding: chunked\r\n\r\n", type);
+    } else {
+        dprintf(fd, "Content-Length: 0\r\n\r\n");
+    }
+}
+
+static void handle(int fd) {
+    char req[2048];
+    ssize_t len = read(fd, req, sizeof(req) - 1);
+    if (len <= 0) return;
+    req[len] = '\0';
+
+    char path[256] = "";
+    sscanf(req, "GET %255s", path);
+    char *query = strchr(path, '?');
+    if (query) *query++ = '\0';
+
+    char *inm = strcasestr(req, "\r\nIf-None-Match:");
+    if (inm) {
+        inm += strlen("\r\nIf-None-Match:");
+        char *eol = strstr(inm, "\r\n");
+        if (eol) *eol = '\0';
+    }
+
+    history_snapshot_t snap;
+    history_api_snapshot(&snap);
+    if (history_api_not_modified(&snap, inm)) {
+        send_head(fd, "304 Not Modified", NULL, snap.etag);
+        return;
+    }
+
+    uint32_t n = history_api_parse_n(query);
+    int res;
+    if (strcmp(path, "/latest") == 0) {
+        send_head(fd, "200 OK", "application/json", snap.etag);
+        res = history_api_latest(&snap, send_chunk, &fd);
+    } else if (strcmp(path, "/history") == 0) {
+        send_head(fd, "200 OK", "application/json", snap.etag);
+        res = history_api_json(&snap, n, send_chunk, &fd);
+    } else if (strcmp(path, "/history.bin") == 0) {
+        send_head(fd, "200 OK", "application/octet-stream", snap.etag);
+        res = history_api_binary(&snap, n, send_chunk, &fd);
+    } else if (strcmp(path, "/rollup") == 0) {
+        send_head(fd, "200 OK", "application/json", snap.etag);
+        res = history_api_rollup(&snap, query, send_chunk, &fd);
+    } else {
+        dprintf(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+    if (res == 0) {
+        send_chunk(&fd, "", 0); // Chunk final
+    }
+}
+
+int main(int argc, char **argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 8080;
+    int srv = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(srv, 4) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+    history_api_init((uint32_t)time(NULL) ^ (uint32_t)getpid());
+    printf("Servindo o histórico em http://127.0.0.1:%d\n", port);
+
+    int64_t next = now_ms();
+    while (1) {
+        // Uma amostra sintética por segundo, como se fosse a station_task
+        while (now_ms() >= next) {
+            push_synthetic(next);
+            next += 1000;
+        }
+        struct pollfd p = {.fd = srv, .events = POLLIN};
+        if (poll(&p, 1, 100) > 0) {
+            int fd = accept(srv, NULL, NULL);
+            if (fd >= 0) {
+                handle(fd);
+                close(fd);
+            }
+        }
+    }
+}
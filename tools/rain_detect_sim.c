@@ -0,0 +1,56 @@
+// Simulador da detecção de chuva e luz do ULP (ferramenta do host)
+//
+// Passa uma série de leituras brutas do ADC pelo mesmo modelo em C que o ULP
+// executa (main/rain_detect.c) e mostra quando a estação seria acordada. Serve
+// para escolher os limiares com dados reais antes de gravá-los no menuconfig.
+//
+// Entrada: uma leitura por linha, "<chuva_raw> <ldr_raw>" (linhas iniciadas
+// por '#' são ignoradas). Cada linha corresponde a um período do ULP.
+//
+// Compilação:
+//   gcc -O2 -Imain -o rain_detect_sim tools/rain_detect_sim.c main/rain_detect.c
+//
+// Uso:
+//   ./rain_detect_sim [rain_on rain_off light_delta] < leituras.txt
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rain_detect.h"
+
+int main(int argc, char **argv) {
+    // Mesmos padrões do Kconfig
+    rain_detect_cfg_t cfg = {.rain_on = 2500, .rain_off = 3200, .light_delta = 600};
+    if (argc == 4) {
+        cfg.rain_on = atoi(argv[1]);
+        cfg.rain_off = atoi(argv[2]);
+        cfg.light_delta = atoi(argv[3]);
+    } else if (argc != 1) {
+        fprintf(stderr, "uso: %s [rain_on rain_off light_delta] < leituras.txt\n", argv[0]);
+        return 1;
+    }
+    if (cfg.rain_off <= cfg.rain_on) {
+        fprintf(stderr, "rain_off (%u) deve ser maior que rain_on (%u)\n", cfg.rain_off, cfg.rain_on);
+        return 1;
+    }
+
+    rain_detect_state_t st = {0};
+    char line[128];
+    unsigned long readings = 0, wakes = 0, rain = 0, light = 0;
+    while (fgets(line, sizeof(line), stdin)) {
+        unsigned chuva, ldr;
+        if (line[0] == '#' || sscanf(line, "%u %u", &chuva, &ldr) != 2) continue;
+        unsigned ev = rain_detect_step(&st, &cfg, chuva, ldr);
+        readings++;
+        if (!ev) continue;
+        wakes++;
+        if (ev & RAIN_DETECT_EVENT_RAIN) rain++;
+        if (ev & RAIN_DETECT_EVENT_LIGHT) light++;
+        printf("leitura %lu: chuva=%u ldr=%u ->%s%s\n", readings, chuva, ldr,
+               ev & RAIN_DETECT_EVENT_RAIN ? " início de chuva" : "",
+               ev & RAIN_DETECT_EVENT_LIGHT ? " mudança de luz" : "");
+    }
+    printf("leituras:%lu | despertares:%lu (%.2f%%) | inícios de chuva:%lu | mudanças de luz:%lu\n",
+           readings, wakes, readings ? 100.0 * wakes / readings : 0.0, rain, light);
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Simulador do histórico em várias resoluções (ferramenta do host)
+//
+// Alimenta history.c e rollup.c com dias de amostras sintéticas num relógio
+// simulado (sem esperar), incluindo falhas do DHT e períodos desligados, e
+// confere cada intervalo de minuto e de hora com o mínimo, o máximo e a média
+// recalculados diretamente das amostras. Em seguida mostra o nível escolhido
+// por rollup_pick() para algumas consultas típicas.
+//
+// Compilação:
+//   gcc -O2 -Imain -DCONFIG_STATION_HISTORY_LEN=360 -DCONFIG_STATION_ROLLUP_MINUTES=240 -DCONFIG_STATION_ROLLUP_HOURS=168 -o rollup_sim tools/rollup_sim.c main/history.c main/rollup.c main/station.c -lm
+//
+// Uso:
+//   ./rollup_sim [dias [período_ms]]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "history.h"
+#include "rollup.h"
+
+#define MAX_SAMPLES (8 * 24 * 3600)     // Até 8 dias a uma amostra por segundo
+
+static station_sample_t s_all[MAX_SAMPLES];    // Todas as amostras, para a conferência
+static size_t s_n;
+
+static station_sample_t synthetic(int64_t t) {
+    double h = t / 3600000.0;
+    station_sample_t s = {.timestamp_ms = t, .seq = (uint32_t)s_n};
+    s.value[STATION_FIELD_TEMPERATURA] = roundf(10 * (22 + 6 * sin(h * M_PI / 12) + (rand() % 10) / 10.0)) / 10;
+    s.value[STATION_FIELD_UMIDADE] = roundf(10 * (65 - 15 * sin(h * M_PI / 12))) / 10;
+    s.value[STATION_FIELD_CHUVA] = fmod(h, 30) < 2 ? 40 + rand() % 50 : rand() % 3;
+    s.value[STATION_FIELD_KY028] = 1800 + rand() % 200;
+    s.value[STATION_FIELD_LUMINOSIDADE] = (int)fmax(0, 100 * sin(h * M_PI / 12));
+    if (rand() % 50 == 0) {
+        // Falha do DHT
+        s.value[STATION_FIELD_TEMPERATURA] = s.value[STATION_FIELD_UMIDADE] = -1;
+        s.invalid = (1u << STATION_FIELD_TEMPERATURA) | (1u << STATION_FIELD_UMIDADE);
+    }
+    return s;
+}
+
+// Valor do campo nas unidades de rollup_bucket_t
+static int16_t field(const station_sample_t *s, int f) {
+    return (int16_t)lroundf(s->value[f] * powf(10, station_fields[f].decimals));
+}
+
+// Contadores da conferência dos intervalos com as amostras originais
+typedef struct {
+    uint32_t period_s;
+    unsigned buckets;
+    unsigned errors;
+} check_t;
+
+static int check_bucket(void *ctx, const rollup_bucket_t *b) {
+    check_t *c = ctx;
+    int16_t min[STATION_FIELD_COUNT], max[STATION_FIELD_COUNT];
+    double sum[STATION_FIELD_COUNT] = {0};
+    unsigned n[STATION_FIELD_COUNT] = {0}, count = 0;
+    for (size_t i = 0; i < s_n; i++) {
+        uint32_t t = (uint32_t)(s_all[i].timestamp_ms / 1000);
+        if (t < b->start_s || t >= b->start_s + c->period_s) continue;
+        count++;
+        for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+            if (s_all[i].invalid & (1u << f)) continue;
+            int16_t v = field(&s_all[i], f);
+            if (!n[f] || v < min[f]) min[f] = v;
+            if (!n[f] || v > max[f]) max[f] = v;
+            sum[f] += v;
+            n[f]++;
+        }
+    }
+    c->buckets++;
+    if (count != b->count) {
+        printf("intervalo %lu: %u amostras, esperado %u\n", (unsigned long)b->start_s, b->count, count);
+        c->errors++;
+        return 0;
+    }
+    for (int f = 0; f < STATION_FIELD_COUNT; f++) {
+        if (!n[f]) continue;
+        // A média das horas vem das médias arredondadas dos minutos: tolera 1 unidade
+        if (min[f] != b->min[f] || max[f] != b->max[f] || fabs(sum[f] / n[f] - b->mean[f]) > 1) {
+            printf("intervalo %lu campo %d: min %d/%d max %d/%d média %.1f/%d\n", (unsigned long)b->start_s, f,
+                   b->min[f], min[f], b->max[f], max[f], sum[f] / n[f], b->mean[f]);
+            c->errors++;
+        }
+    }
+    return 0;
+}
+
+static int count_bucket(void *ctx, const rollup_bucket_t *b) {
+    (void)b;
+    (*(unsigned *)ctx)++;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    double days = argc > 1 ? atof(argv[1]) : 3;
+    int64_t period_ms = argc > 2 ? atoll(argv[2]) : 5000;
+    srand(1);
+
+    // Amostragem com dois períodos desligados, que não devem gerar intervalos
+    int64_t end_ms = (int64_t)(days * 86400000);
+    for (int64_t t = 0; t < end_ms && s_n < MAX_SAMPLES; t += period_ms) {
+        int64_t h = t / 3600000;
+        if (h == 5 || (h >= 30 && h < 33)) continue;
+        s_all[s_n] = synthetic(t);
+        history_push(&s_all[s_n]);
+        rollup_push(&s_all[s_n]);
+        s_n++;
+    }
+    printf("%zu amostras em %.1f dias, uma a cada %lld ms\n", s_n, days, (long long)period_ms);
+    printf("memória: minutos %zu bytes, horas %zu bytes\n", ROLLUP_MINUTES * sizeof(rollup_bucket_t),
+           ROLLUP_HOURS * sizeof(rollup_bucket_t));
+
+    unsigned errors = 0;
+    for (rollup_tier_t tier = ROLLUP_TIER_MINUTE; tier < ROLLUP_TIERS; tier++) {
+        check_t c = {.period_s = rollup_period_s(tier)};
+        if (rollup_query(tier, 0, UINT32_MAX, check_bucket, &c) != 0) c.errors++;
+        printf("nível %-4s: %u intervalos conferidos, %u divergências\n", rollup_tier_name(tier), c.buckets, c.errors);
+        errors += c.errors;
+    }
+
+    // Consultas terminando na amostra mais recente
+    uint32_t now_s = (uint32_t)(s_all[s_n - 1].timestamp_ms / 1000);
+    static const struct {
+        uint32_t span_s;
+        uint32_t points;
+    } queries[] = {
+        {600, 0}, {1800, 120}, {3600, 0}, {3 * 3600, 0}, {3 * 3600, 60}, {86400, 0}, {7 * 86400, 0},
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        uint32_t from_s = queries[i].span_s < now_s ? now_s - queries[i].span_s : 0;
+        rollup_tier_t tier = rollup_pick(from_s, now_s, queries[i].points);
+        unsigned n = 0;
+        rollup_query(tier, from_s, now_s, count_bucket, &n);
+        printf("últimos %6lu s, até %3lu pontos -> nível %-4s com %u intervalos\n", (unsigned long)queries[i].span_s,
+               (unsigned long)queries[i].points, rollup_tier_name(tier), n);
+    }
+    return errors ? 1 : 0;
+}
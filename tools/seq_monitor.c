@@ -0,0 +1,148 @@
+// Monitor de perdas, reordenação e latência das amostras (ferramenta do host)
+//
+// Lê as mensagens do tópico de dados, uma por linha, no formato
+// "<instante de recebimento em segundos> <json>" gerado pelo mosquitto_sub -F,
+// e usa os campos seq e ts de cada amostra para calcular:
+//  - perdas: números de sequência que nunca chegaram
+//  - reordenação: amostras que chegaram depois de uma sequência maior
+//  - duplicatas: amostras recebidas mais de uma vez (reentregas QoS 1)
+//  - latência: percentis de (recebimento - captura). Como o relógio da estação
+//    conta a partir do boot, a latência é relativa à menor diferença observada,
+//    ou seja, mede o atraso acima do melhor caso.
+// Linhas sem instante de recebimento (ex.: saída do backfill_decode) entram
+// nas contagens de perda, mas não na latência.
+//
+// Compilação:
+//   gcc -O2 -o seq_monitor tools/seq_monitor.c
+//
+// Uso:
+//   mosquitto_sub -h localhost -t /ifpe/ads/embarcados/esp32/station/data -F '%U %p' | ./seq_monitor
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORT_EVERY 100    // Relatório a cada N mensagens
+#define RESTART_GAP  1000   // Queda de sequência maior que isto indica reboot da estação
+
+typedef struct {
+    uint8_t *seen;          // seen[seq - base] != 0 se a amostra já chegou
+    size_t seen_len;
+    uint32_t base;          // Menor sequência recebida
+    uint32_t max_seq;
+    uint32_t received;
+    uint32_t unique;
+    uint32_t reordered;
+    uint32_t duplicates;
+    double *delays;         // (recebimento - captura) em ms
+    size_t ndelays, cap_delays;
+    double min_delay;
+} session_t;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(session_t *s) {
+    if (s->received == 0) return;
+    uint32_t expected = s->max_seq - s->base + 1;
+    uint32_t lost = expected - s->unique;
+    printf("recebidas:%u | únicas:%u | perdidas:%u (%.2f%%) | reordenadas:%u | duplicadas:%u",
+           s->received, s->unique, lost, 100.0 * lost / expected, s->reordered, s->duplicates);
+    if (s->ndelays) {
+        double *sorted = malloc(s->ndelays * sizeof(double));
+        memcpy(sorted, s->delays, s->ndelays * sizeof(double));
+        qsort(sorted, s->ndelays, sizeof(double), cmp_double);
+        const unsigned pcts[] = {50, 90, 99};
+        printf(" | latência relativa (ms)");
+        for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+            size_t idx = (s->ndelays * pcts[i] + 99) / 100;
+            printf(" p%u:%.0f", pcts[i], sorted[idx ? idx - 1 : 0] - s->min_delay);
+        }
+        printf(" max:%.0f", sorted[s->ndelays - 1] - s->min_delay);
+        free(sorted);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static void reset(session_t *s) {
+    free(s->seen);
+    free(s->delays);
+    memset(s, 0, sizeof(*s));
+}
+
+static void add(session_t *s, uint32_t seq, int has_recv, double recv_ms, long long ts) {
+    if (s->received == 0) {
+        s->base = seq;
+        s->max_seq = seq;
+    }
+    if (seq < s->base) {
+        // Chegou uma sequência anterior à primeira vista: desloca o mapa
+        size_t shift = s->base - seq;
+        uint8_t *seen = calloc(s->seen_len + shift, 1);
+        memcpy(seen + shift, s->seen, s->seen_len);
+        free(s->seen);
+        s->seen = seen;
+        s->seen_len += shift;
+        s->base = seq;
+    }
+    size_t idx = seq - s->base;
+    if (idx >= s->seen_len) {
+        size_t len = (idx + 1) * 2;
+        s->seen = realloc(s->seen, len);
+        memset(s->seen + s->seen_len, 0, len - s->seen_len);
+        s->seen_len = len;
+    }
+
+    s->received++;
+    if (s->seen[idx]) {
+        s->duplicates++;
+    } else {
+        s->seen[idx] = 1;
+        s->unique++;
+        if (seq < s->max_seq) s->reordered++;
+    }
+    if (seq > s->max_seq) s->max_seq = seq;
+
+    if (has_recv) {
+        double delay = recv_ms - (double)ts;
+        if (s->ndelays == s->cap_delays) {
+            s->cap_delays = s->cap_delays ? s->cap_delays * 2 : 1024;
+            s->delays = realloc(s->delays, s->cap_delays * sizeof(double));
+        }
+        if (s->ndelays == 0 || delay < s->min_delay) s->min_delay = delay;
+        s->delays[s->ndelays++] = delay;
+    }
+}
+
+int main(void) {
+    session_t s = {0};
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) {
+        const char *json = strchr(line, '{');
+        const char *seq_p = json ? strstr(json, "\"seq\":") : NULL;
+        const char *ts_p = json ? strstr(json, "\"ts\":") : NULL;
+        if (!seq_p || !ts_p) continue;
+
+        uint32_t seq = strtoul(seq_p + 6, NULL, 10);
+        long long ts = strtoll(ts_p + 5, NULL, 10);
+        char *end;
+        double recv_s = strtod(line, &end);
+        int has_recv = end != line && end <= json;
+
+        // Sequência reiniciada: a estação reiniciou, começa uma nova sessão
+        if (s.received && seq + RESTART_GAP < s.max_seq) {
+            printf("-- estação reiniciada (seq %u -> %u) --\n", s.max_seq, seq);
+            report(&s);
+            reset(&s);
+        }
+        add(&s, seq, has_recv, recv_s * 1000.0, ts);
+        if (s.received % REPORT_EVERY == 0) report(&s);
+    }
+    report(&s);
+    reset(&s);
+    return 0;
+}